@@ -26,224 +26,2730 @@
 // NOLINTBEGIN
 
 #include "QJsonModel.hpp"
+#include "details/QJsonCborParser.hpp"
+#include "details/QJsonEscape.hpp"
+#include "details/QJsonSaxParser.hpp"
+#include "details/QJsonSnapshot.hpp"
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QCborStreamWriter>
+#include <QDateTime>
 #include <QFile>
+#include <QFileInfo>
 #include <QFont>
+#include <QHash>
+#include <QRegularExpression>
+#include <QSaveFile>
+#include <QSet>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <utility>
+#include <vector>
 
-inline bool contains(const QStringList &list, const QString &value) {
-  for (auto val : list)
-    if (value.contains(val, Qt::CaseInsensitive))
-      return true;
+QJsonTreeItem::QJsonTreeItem(QJsonTreeItem *parent) { mParent = parent; }
 
-  return false;
+QJsonTreeItem::~QJsonTreeItem() {
+  // Arena nodes are destroyed by their arena, never through their parent
+  for (QJsonTreeItem *child : std::as_const(mChilds))
+    if (!child->mArenaOwned)
+      delete child;
+  delete mExtra;
 }
 
-QJsonTreeItem::QJsonTreeItem(QJsonTreeItem *parent) { mParent = parent; }
+QJsonTreeItem::Extra &QJsonTreeItem::extra() {
+  if (!mExtra)
+    mExtra = new Extra;
+  return *mExtra;
+}
+
+QJsonTreeItem::LazySource *QJsonTreeItem::lazySource() const {
+  return mExtra ? mExtra->lazy.get() : nullptr;
+}
+
+QHash<QString, QJsonTreeItem *> *QJsonTreeItem::keyIndex() const {
+  return mExtra ? mExtra->keyIndex.get() : nullptr;
+}
+
+int QJsonTreeItem::firstStaleRow() const {
+  return mExtra ? mExtra->firstStaleRow : NoStaleRow;
+}
+
+qsizetype QJsonTreeItem::sourceIndex() const {
+  return mExtra && mExtra->sourceIndex >= 0 ? mExtra->sourceIndex : row();
+}
+
+QJsonTreeItem *QJsonTreeItem::create(QJsonTreeItem *parent,
+                                     QJsonTreeArena *arena) {
+  if (!arena)
+    return new QJsonTreeItem(parent);
+
+  QJsonTreeItem *item = arena->create(parent);
+  item->mArenaOwned = true;
+  return item;
+}
+
+void QJsonTreeItem::destroyArena(QJsonTreeArena &arena) {
+  // Heap children must go while all arena nodes are still alive, since
+  // nodes may have been moved below parents created after them.
+  arena.forEach([](QJsonTreeItem &item) {
+    for (QJsonTreeItem *child : std::as_const(item.mChilds))
+      if (!child->mArenaOwned)
+        delete child;
+    item.mChilds.clear();
+  });
+  arena.clear();
+}
+
+bool QJsonTreeItem::isArenaOwned() const { return mArenaOwned; }
+
+void QJsonTreeItem::appendChild(QJsonTreeItem *item) {
+  item->mParent = this;
+  item->mRow = mChilds.size();
+  mChilds.append(item);
+  indexKey(item);
+}
+
+void QJsonTreeItem::insertChild(int row, QJsonTreeItem *item) {
+  row = qBound(0, row, int(mChilds.size()));
+  item->mParent = this;
+  item->mRow = row;
+  mChilds.insert(row, item);
+  markRowsStale(row);
+  indexKey(item);
+}
+
+QJsonTreeItem *QJsonTreeItem::takeChild(int row) {
+  if (row < 0 || row >= mChilds.size())
+    return nullptr;
+
+  QJsonTreeItem *item = mChilds.takeAt(row);
+  markRowsStale(row);
+  unindexKey(item);
+  item->mParent = nullptr;
+  item->mRow = 0;
+  return item;
+}
+
+void QJsonTreeItem::removeChildren(int row, int count) {
+  if (row < 0 || count <= 0 || row + count > mChilds.size())
+    return;
+
+  for (int i = row; i < row + count; ++i) {
+    unindexKey(mChilds.at(i));
+    if (!mChilds.at(i)->mArenaOwned)
+      delete mChilds.at(i);
+  }
+  mChilds.remove(row, count);
+  markRowsStale(row);
+}
+
+void QJsonTreeItem::insertChildren(int row,
+                                   const QList<QJsonTreeItem *> &items) {
+  row = qBound(0, row, int(mChilds.size()));
+  mChilds.insert(row, items.size(), nullptr);
+  for (qsizetype i = 0; i < items.size(); ++i) {
+    items.at(i)->mParent = this;
+    items.at(i)->mRow = row + int(i);
+    mChilds[row + i] = items.at(i);
+    indexKey(items.at(i));
+  }
+  markRowsStale(row);
+}
+
+QList<QJsonTreeItem *> QJsonTreeItem::takeChildren() {
+  if (mExtra) {
+    mExtra->keyIndex.reset();
+    mExtra->firstStaleRow = NoStaleRow;
+  }
+  QList<QJsonTreeItem *> children = mChilds.toList();
+  mChilds.clear();
+  for (QJsonTreeItem *child : std::as_const(children)) {
+    child->mParent = nullptr;
+    child->mRow = 0;
+  }
+  return children;
+}
 
-QJsonTreeItem::~QJsonTreeItem() { qDeleteAll(mChilds); }
+QList<QJsonTreeItem *> QJsonTreeItem::takeChildren(int row, int count) {
+  if (row < 0 || count <= 0 || row + count > mChilds.size())
+    return {};
 
-void QJsonTreeItem::appendChild(QJsonTreeItem *item) { mChilds.append(item); }
+  const QList<QJsonTreeItem *> items = mChilds.mid(row, count);
+  for (QJsonTreeItem *item : items) {
+    unindexKey(item);
+    item->mParent = nullptr;
+    item->mRow = 0;
+  }
+  mChilds.remove(row, count);
+  markRowsStale(row);
+  return items;
+}
 
 QJsonTreeItem *QJsonTreeItem::child(int row) { return mChilds.value(row); }
 
+QJsonTreeItem *QJsonTreeItem::childByKey(const QString &key) {
+  // Objects that grew past the threshold after loading get their hash now
+  if (!keyIndex() && mChilds.size() >= KeyIndexThreshold)
+    buildKeyIndex();
+  if (const auto *index = keyIndex())
+    return index->value(key);
+
+  for (QJsonTreeItem *child : std::as_const(mChilds))
+    if (child->mKey == key)
+      return child;
+  return nullptr;
+}
+
+void QJsonTreeItem::buildKeyIndex() {
+  if (QJsonValue::Object != mType || mChilds.size() < KeyIndexThreshold)
+    return;
+
+  auto index = std::make_unique<QHash<QString, QJsonTreeItem *>>();
+  index->reserve(mChilds.size());
+  for (QJsonTreeItem *child : std::as_const(mChilds))
+    index->insert(child->mKey, child);
+  extra().keyIndex = std::move(index);
+}
+
+void QJsonTreeItem::indexKey(QJsonTreeItem *child) {
+  if (auto *index = keyIndex())
+    index->insert(child->mKey, child);
+}
+
+void QJsonTreeItem::unindexKey(QJsonTreeItem *child) {
+  // A duplicate key may point at another child; leave that one
+  auto *index = keyIndex();
+  if (index && index->value(child->mKey) == child)
+    index->remove(child->mKey);
+}
+
 QJsonTreeItem *QJsonTreeItem::parent() { return mParent; }
 
-int QJsonTreeItem::childCount() const { return mChilds.count(); }
+int QJsonTreeItem::childCount() const { return mChilds.size(); }
 
 int QJsonTreeItem::row() const {
-  if (mParent)
-    return mParent->mChilds.indexOf(const_cast<QJsonTreeItem *>(this));
+  if (mParent && mRow >= mParent->firstStaleRow())
+    mParent->renumberRows();
+  return mRow;
+}
+
+void QJsonTreeItem::markRowsStale(int row) {
+  if (row < firstStaleRow())
+    extra().firstStaleRow = row;
+}
+
+void QJsonTreeItem::renumberRows() const {
+  if (!mExtra)
+    return;
+  for (qsizetype i = mExtra->firstStaleRow; i < mChilds.size(); ++i)
+    mChilds.at(i)->mRow = int(i);
+  mExtra->firstStaleRow = NoStaleRow;
+}
+
+void QJsonTreeItem::setKey(const QString &key) {
+  // Items being built already point at their parent, but are not among its
+  // children yet; appending them indexes their key
+  const bool indexed = mParent && mParent->keyIndex() &&
+                       mParent->mChilds.value(row()) == this;
+  if (indexed)
+    mParent->unindexKey(this);
+  mKey = key;
+  if (indexed)
+    mParent->indexKey(this);
+}
+
+bool QJsonTreeItem::setValue(const QVariant &value) {
+  // Editors hand everything back as text; read it as the item's type
+  QJsonScalar scalar = QJsonScalar::fromVariant(value);
+  switch (mType) {
+  case QJsonValue::Null:
+    // Null items, such as rows just inserted, take the type of the value:
+    // text spelling a JSON literal or a number reads as one
+    if (scalar.isString()) {
+      const QString text = scalar.text().trimmed();
+      bool isInteger = false;
+      bool isDouble = false;
+      const qint64 integer = text.toLongLong(&isInteger);
+      const double d = isInteger ? 0 : text.toDouble(&isDouble);
+      if (isInteger)
+        scalar = integer;
+      else if (isDouble && qIsFinite(d))
+        scalar = d;
+      else if (text == QLatin1String("true"))
+        scalar = true;
+      else if (text == QLatin1String("false"))
+        scalar = false;
+      else if (text == QLatin1String("null"))
+        scalar = nullptr;
+    }
+    if (scalar.isNull()) {
+      scalar = nullptr;
+      break;
+    }
+    mType = quint8(QJsonScalar::Bool == scalar.kind() ? QJsonValue::Bool
+                   : scalar.isNumber()               ? QJsonValue::Double
+                                                     : QJsonValue::String);
+    break;
+  case QJsonValue::Bool:
+    if (scalar.isString()) {
+      const QString text = scalar.text().trimmed();
+      if (text == QLatin1String("true"))
+        scalar = true;
+      else if (text == QLatin1String("false"))
+        scalar = false;
+    }
+    if (QJsonScalar::Bool != scalar.kind())
+      return false;
+    break;
+  case QJsonValue::Double:
+    if (scalar.isString()) {
+      const QString text = scalar.text().trimmed();
+      bool ok = false;
+      const qint64 integer = text.toLongLong(&ok);
+      if (ok) {
+        scalar = integer;
+      } else {
+        const double d = text.toDouble(&ok);
+        if (!ok || !qIsFinite(d))
+          return false;
+        scalar = d;
+      }
+    }
+    if (!scalar.isNumber())
+      return false;
+    break;
+  case QJsonValue::String:
+    if (scalar.isNull())
+      return false;
+    if (!scalar.isString())
+      scalar = scalar.toString();
+    break;
+  default: // Objects and arrays hold no value of their own
+    return false;
+  }
+  mValue = std::move(scalar);
+  return true;
+}
+
+void QJsonTreeItem::setScalar(QJsonScalar value) {
+  mValue = std::move(value);
+}
+
+void QJsonTreeItem::setType(const QJsonValue::Type &type) {
+  mType = quint8(type);
+}
+
+QString QJsonTreeItem::key() const {
+  if (mKey.isNull() && mParent && QJsonValue::Array == mParent->mType)
+    return QString::number(row());
+  return mKey;
+}
+
+QVariant QJsonTreeItem::value() const { return mValue.toVariant(); }
+
+const QJsonScalar &QJsonTreeItem::scalar() const { return mValue; }
+
+QJsonValue::Type QJsonTreeItem::type() const {
+  return QJsonValue::Type(mType);
+}
+
+struct QJsonTreeItem::LoadContext {
+  const QJsonKeyFilter &filter;
+  QJsonTreeArena *arena = nullptr;
+  //! Filter state of the container whose children are being built.
+  QJsonKeyFilter::State path;
+  //! Keeps object members in document order instead of sorting them like
+  //! QJsonObject. Only the native parser sees the document order.
+  bool keepKeyOrder = false;
+  //! Set from another thread to abort the load.
+  const std::atomic_bool *cancel = nullptr;
+  //! Called with the number of nodes built every ProgressInterval nodes.
+  std::function<void(qint64)> progress;
+  qint64 nodes = 0;
+  //! Wide documents with at least parallelThreshold top-level members are
+  //! parsed by this many threads (see QJsonTreeBuilder::parse()).
+  int threads = 1;
+  qsizetype parallelThreshold = 0;
+  QJsonKeyPool keys;
+
+  static constexpr qint64 ProgressInterval = 16 * 1024;
+
+  bool cancelled() const {
+    return cancel && cancel->load(std::memory_order_relaxed);
+  }
+  void countNode() {
+    if (++nodes % ProgressInterval == 0 && progress)
+      progress(nodes);
+  }
+};
+
+QJsonTreeItem *QJsonTreeItem::load(const QJsonValue &value,
+                                   const QStringList &exceptions,
+                                   QJsonTreeItem *parent,
+                                   QJsonTreeArena *arena) {
+  const QJsonKeyFilter filter(exceptions);
+  LoadContext context{filter, arena};
+  context.path = filter.rootState();
+  return load(value, context, parent);
+}
+
+QJsonTreeItem *QJsonTreeItem::load(const QJsonValue &value,
+                                   LoadContext &context,
+                                   QJsonTreeItem *parent) {
+  QJsonTreeItem *rootItem = create(parent, context.arena);
+  if (!parent)
+    rootItem->setKey("root");
+  context.countNode();
+
+  rootItem->setType(value.type());
+  if (value.isObject() || value.isArray())
+    rootItem->loadChildren(value, context);
+  else
+    rootItem->setScalar(QJsonScalar::fromJsonValue(value));
+
+  return rootItem;
+}
+
+void QJsonTreeItem::loadChildren(const QJsonValue &value,
+                                 LoadContext &context) {
+  const bool isObject = value.isObject();
+  const QJsonObject object = value.toObject(); // To prevent clazy-range warning
+  const QJsonArray array = value.toArray();
+  const qsizetype count = isObject ? object.size() : array.size();
+
+  const QJsonKeyFilter::State here = context.path;
+  mChilds.reserve(count);
+  auto it = object.constBegin();
+  for (qsizetype i = 0; i < count; ++i) {
+    if (context.cancelled())
+      break;
+    QString key;
+    QJsonValue v;
+    if (isObject) {
+      key = it.key();
+      v = it.value();
+      ++it;
+      if (context.filter.skipMember(here, key, context.path))
+        continue;
+    } else {
+      v = array.at(i);
+      if (context.filter.skipElement(here, i, context.path))
+        continue;
+      context.keys.skipIndex(i);
+    }
+    QJsonTreeItem *child = load(v, context, this);
+    if (isObject)
+      child->setKey(context.keys.intern(std::move(key)));
+    appendChild(child);
+  }
+  context.path = here;
+  buildKeyIndex();
+}
+
+QJsonTreeItem *QJsonTreeItem::loadLazy(const QJsonValue &value,
+                                       QJsonTreeItem *parent) {
+  QJsonTreeItem *item = new QJsonTreeItem(parent);
+  if (!parent)
+    item->setKey("root");
+  item->setType(value.type());
+
+  if (value.isObject() || value.isArray())
+    item->extra().lazy.reset(new LazySource{value});
+  else
+    item->setScalar(QJsonScalar::fromJsonValue(value));
+
+  return item;
+}
+
+bool QJsonTreeItem::canFetchMore() const {
+  const LazySource *lazy = lazySource();
+  if (!lazy)
+    return false;
+  if (lazy->source.isObject())
+    return lazy->offset < lazy->source.toObject().size();
+
+  return lazy->offset < lazy->source.toArray().size();
+}
+
+QList<QJsonTreeItem *> QJsonTreeItem::fetchMore(int count,
+                                                const QJsonKeyFilter &filter,
+                                                QJsonKeyPool *keys) {
+  LazySource *lazy = lazySource();
+  if (!lazy)
+    return {};
+
+  QList<QJsonTreeItem *> items =
+      buildChildren(lazy->offset, count, filter, keys);
+
+  // Drop the reference to the source document once everything is built
+  if (!canFetchMore())
+    mExtra->lazy.reset();
+
+  return items;
+}
+
+QList<QJsonTreeItem *>
+QJsonTreeItem::pendingChildren(const QJsonKeyFilter &filter) const {
+  const LazySource *lazy = lazySource();
+  if (!lazy)
+    return {};
+
+  qsizetype offset = lazy->offset;
+  return buildChildren(offset, INT_MAX, filter, nullptr);
+}
+
+qsizetype QJsonTreeItem::nodeBytes() const {
+  qsizetype bytes = sizeof(QJsonTreeItem) +
+                    mChilds.capacity() * qsizetype(sizeof(QJsonTreeItem *));
+  if (mExtra)
+    bytes += sizeof(Extra);
+  if (lazySource())
+    bytes += sizeof(LazySource);
+  if (const auto *index = keyIndex())
+    bytes += sizeof(*index) +
+             index->capacity() *
+                 qsizetype(sizeof(QString) + sizeof(QJsonTreeItem *));
+  return bytes;
+}
+
+QJsonKeyFilter::State
+QJsonTreeItem::filterState(const QJsonKeyFilter &filter) const {
+  QJsonKeyFilter::State state = filter.rootState();
+  if (!filter.hasPathRules())
+    return state;
+
+  QList<const QJsonTreeItem *> path;
+  for (const QJsonTreeItem *item = this; item->mParent; item = item->mParent)
+    path.prepend(item);
+  for (const QJsonTreeItem *item : std::as_const(path)) {
+    QJsonKeyFilter::State next;
+    if (QJsonValue::Array == item->mParent->mType)
+      filter.skipElement(state, item->sourceIndex(), next);
+    else
+      filter.skipMember(state, item->key(), next);
+    state = next;
+  }
+  return state;
+}
+
+QList<QJsonTreeItem *>
+QJsonTreeItem::buildChildren(qsizetype &offset, int count,
+                             const QJsonKeyFilter &filter,
+                             QJsonKeyPool *keys) const {
+  QList<QJsonTreeItem *> items;
+  // Children are parented and numbered as if appended, which pending
+  // children never are, so that their own subtrees can be filtered by path
+  QJsonTreeItem *self = const_cast<QJsonTreeItem *>(this);
+  const QJsonKeyFilter::State here = filterState(filter);
+  QJsonKeyFilter::State path;
+  const QJsonValue &source = lazySource()->source;
+
+  if (source.isObject()) {
+    const QJsonObject object = source.toObject();
+    auto it = object.constBegin() + offset;
+    for (; it != object.constEnd() && items.size() < count; ++it) {
+      ++offset;
+      if (filter.skipMember(here, it.key(), path))
+        continue;
+      QJsonTreeItem *child = loadLazy(it.value(), self);
+      child->setKey(keys ? keys->intern(it.key()) : it.key());
+      child->mRow = int(mChilds.size() + items.size());
+      items.append(child);
+    }
+  } else if (source.isArray()) {
+    const QJsonArray array = source.toArray();
+    const qsizetype end = qMin<qsizetype>(array.size(), offset + count);
+    for (; offset < end; ++offset) {
+      if (filter.skipElement(here, offset, path))
+        continue;
+      QJsonTreeItem *child = loadLazy(array.at(offset), self);
+      if (keys)
+        keys->skipIndex(offset);
+      // Containers have their children filtered by the source path later
+      if (child->lazySource())
+        child->mExtra->sourceIndex = offset;
+      child->mRow = int(mChilds.size() + items.size());
+      items.append(child);
+    }
+  }
+
+  return items;
+}
+
+void QJsonTreeItem::finishObject(bool keepOrder) {
+  if (mChilds.size() < 2)
+    return;
+
+  if (!keepOrder)
+    std::stable_sort(mChilds.begin(), mChilds.end(),
+                     [](const QJsonTreeItem *a, const QJsonTreeItem *b) {
+                       return a->mKey < b->mKey;
+                     });
+
+  // The last duplicate key wins, as in QJsonDocument
+  QList<bool> dropped(mChilds.size(), false);
+  bool hasDuplicates = false;
+  if (!keepOrder) {
+    for (int i = 0; i + 1 < mChilds.size(); ++i)
+      if (mChilds.at(i)->mKey == mChilds.at(i + 1)->mKey)
+        hasDuplicates = dropped[i] = true;
+  } else if (mChilds.size() <= 16) {
+    for (int i = 0; i < mChilds.size(); ++i)
+      for (int j = i + 1; j < mChilds.size() && !dropped.at(i); ++j)
+        if (mChilds.at(i)->mKey == mChilds.at(j)->mKey)
+          hasDuplicates = dropped[i] = true;
+  } else {
+    QSet<QString> seen;
+    seen.reserve(mChilds.size());
+    for (int i = mChilds.size() - 1; i >= 0; --i) {
+      const qsizetype before = seen.size();
+      seen.insert(mChilds.at(i)->mKey);
+      if (seen.size() == before)
+        hasDuplicates = dropped[i] = true;
+    }
+  }
+
+  if (hasDuplicates) {
+    int kept = 0;
+    for (int i = 0; i < mChilds.size(); ++i) {
+      if (!dropped.at(i))
+        mChilds[kept++] = mChilds.at(i);
+      else if (!mChilds.at(i)->mArenaOwned)
+        delete mChilds.at(i);
+    }
+    mChilds.remove(kept, mChilds.size() - kept);
+  }
+
+  for (int i = 0; i < mChilds.size(); ++i)
+    mChilds[i]->mRow = i;
+  if (mExtra)
+    mExtra->firstStaleRow = NoStaleRow;
+  buildKeyIndex();
+}
+
+//=========================================================================
+
+//! QJsonSaxParser and QJsonCborParser handler building QJsonTreeItem nodes
+//! as tokens arrive, so the document never exists as a QJsonDocument DOM.
+class QJsonTreeBuilder {
+public:
+  //! With a \a container, top-level values become its children; they are
+  //! collected in items() instead of being appended, since chunks of one
+  //! container are built concurrently. \a firstIndex is the array index of
+  //! the first of them.
+  explicit QJsonTreeBuilder(QJsonTreeItem::LoadContext &context,
+                            QJsonTreeItem *container = nullptr,
+                            qsizetype firstIndex = 0)
+      : mContext(context), mContainer(container), mIndex(firstIndex),
+        mPathRules(context.filter.hasPathRules()), mChildPath(context.path) {}
+
+  //! Parses \a json into a new tree. Returns null and fills \a error when
+  //! the text is invalid or the load was cancelled.
+  static QJsonTreeItem *parse(const QByteArray &json,
+                              QJsonTreeItem::LoadContext &context,
+                              QJsonParseError &error) {
+    error = QJsonParseError();
+    QJsonSaxSplit split;
+    if (context.threads > 1 && json.size() >= 2 * context.parallelThreshold &&
+        split.scan(json.constData(), json.size()) &&
+        split.count() >= context.parallelThreshold)
+      return parseParallel(json, split, context, error);
+
+    QJsonTreeBuilder builder(context);
+    QJsonSaxParser<QJsonTreeBuilder> parser(json.constData(), json.size(),
+                                            builder);
+    if (!parser.parseDocument()) {
+      error.error = parser.error();
+      error.offset = int(parser.errorOffset());
+      // The arena, if any, is freed by the caller; a heap tree is ours
+      if (builder.mRoot && !builder.mRoot->isArenaOwned())
+        delete builder.mRoot;
+      return nullptr;
+    }
+    return builder.mRoot;
+  }
+
+  //! Reads the CBOR document \a cbor into a new tree. Returns null and
+  //! fills \a error when the data is invalid or the load was cancelled.
+  static QJsonTreeItem *parseCbor(const QByteArray &cbor,
+                                  QJsonTreeItem::LoadContext &context,
+                                  QCborParserError &error) {
+    error = QCborParserError();
+    QJsonTreeBuilder builder(context);
+    QJsonCborParser<QJsonTreeBuilder> parser(cbor, builder);
+    if (!parser.parseDocument()) {
+      error.error = parser.error();
+      error.offset = parser.errorOffset();
+      if (builder.mRoot && !builder.mRoot->isArenaOwned())
+        delete builder.mRoot;
+      return nullptr;
+    }
+    return builder.mRoot;
+  }
+
+  //! Parses one JSON Lines record into a new child of \a container at
+  //! \a index, which is left to the caller to append. Returns null and
+  //! fills \a error unless the text holds exactly one value; a record the
+  //! filter excludes returns null without an error.
+  static QJsonTreeItem *parseRecord(const char *data, qsizetype size,
+                                    QJsonTreeItem::LoadContext &context,
+                                    QJsonTreeItem *container, qsizetype index,
+                                    QJsonParseError &error) {
+    error = QJsonParseError();
+    QJsonTreeBuilder builder(context, container, index);
+    QJsonSaxParser<QJsonTreeBuilder> parser(data, size, builder, 1);
+    const bool ok = parser.parseMembers(false);
+    if (ok && builder.mItems.size() == 1)
+      return builder.mItems.first();
+    if (ok && builder.mItems.isEmpty())
+      return nullptr; // Excluded by a path rule; not an error
+
+    error.error = parser.error() != QJsonParseError::NoError
+                      ? parser.error()
+                      : QJsonParseError::GarbageAtEnd;
+    error.offset = int(parser.errorOffset());
+    for (QJsonTreeItem *item : std::as_const(builder.mItems)) {
+      if (!item->isArenaOwned())
+        delete item;
+    }
+    return nullptr;
+  }
+
+  bool startObject() { return push(QJsonValue::Object); }
+  bool endObject() {
+    pop()->finishObject(mContext.keepKeyOrder);
+    return true;
+  }
+  bool startArray() { return push(QJsonValue::Array); }
+  bool endArray() {
+    pop();
+    return true;
+  }
+  QJsonSax::KeyAction key(QString &&key) {
+    // Excluded subtrees are skipped by the parser, never allocated
+    if (mContext.filter.skipMember(path(), key, mChildPath))
+      return QJsonSax::Skip;
+    mKey = std::move(key);
+    return QJsonSax::Accept;
+  }
+  QJsonSax::KeyAction element() {
+    if (!mPathRules)
+      return QJsonSax::Accept;
+    qsizetype &index = mStack.isEmpty() ? mIndex : mIndices.last();
+    return mContext.filter.skipElement(path(), index++, mChildPath)
+               ? QJsonSax::Skip
+               : QJsonSax::Accept;
+  }
+  bool string(QString &&value) {
+    add(QJsonValue::String)->setScalar(std::move(value));
+    return !mContext.cancelled();
+  }
+  bool number(const char *text, qsizetype length, bool isInteger) {
+    add(QJsonValue::Double)->setScalar(numberValue(text, length, isInteger));
+    return !mContext.cancelled();
+  }
+  bool integer(qint64 value) {
+    add(QJsonValue::Double)->setScalar(value);
+    return !mContext.cancelled();
+  }
+  bool real(double value) {
+    add(QJsonValue::Double)->setScalar(value);
+    return !mContext.cancelled();
+  }
+  bool boolean(bool value) {
+    add(QJsonValue::Bool)->setScalar(value);
+    return !mContext.cancelled();
+  }
+  bool null() {
+    add(QJsonValue::Null)->setScalar(nullptr);
+    return !mContext.cancelled();
+  }
+
+private:
+  //! Splits a wide top-level container into chunks of members that are
+  //! parsed concurrently, then stitched under one root in order.
+  static QJsonTreeItem *parseParallel(const QByteArray &json,
+                                      const QJsonSaxSplit &split,
+                                      QJsonTreeItem::LoadContext &context,
+                                      QJsonParseError &error) {
+    QJsonTreeItem *root = QJsonTreeItem::create(nullptr, context.arena);
+    root->setKey("root");
+    root->setType(split.isObject ? QJsonValue::Object : QJsonValue::Array);
+    context.countNode();
+
+    struct Chunk {
+      QJsonTreeArena arena;
+      QList<QJsonTreeItem *> items;
+      qint64 nodes = 0;
+      qint64 keyBytesSaved = 0;
+      bool ok = false;
+      QJsonParseError::ParseError error = QJsonParseError::NoError;
+      qsizetype errorOffset = 0;
+    };
+    const qsizetype count = split.count();
+    const qsizetype chunkCount = qMin<qsizetype>(count, context.threads * 4);
+    std::vector<Chunk> chunks(chunkCount);
+    std::atomic<qint64> progressNodes{context.nodes};
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(context.threads);
+    for (qsizetype c = 0; c < chunkCount; ++c) {
+      pool.start([&, c] {
+        Chunk &chunk = chunks[c];
+        const qsizetype first = count * c / chunkCount;
+        const qsizetype last = count * (c + 1) / chunkCount - 1;
+        const qsizetype begin = split.begins.at(first);
+
+        QJsonTreeItem::LoadContext local{
+            context.filter, context.arena ? &chunk.arena : nullptr};
+        local.keepKeyOrder = context.keepKeyOrder;
+        local.cancel = context.cancel;
+        if (context.progress) {
+          local.progress = [&](qint64) {
+            context.progress(progressNodes +=
+                             QJsonTreeItem::LoadContext::ProgressInterval);
+          };
+        }
+
+        local.path = context.path;
+
+        QJsonTreeBuilder builder(local, root, first);
+        QJsonSaxParser<QJsonTreeBuilder> parser(json.constData() + begin,
+                                                split.ends.at(last) - begin,
+                                                builder, 1);
+        chunk.ok = parser.parseMembers(split.isObject);
+        chunk.error = parser.error();
+        chunk.errorOffset = begin + parser.errorOffset();
+        chunk.items = builder.mItems;
+        chunk.nodes = local.nodes;
+        chunk.keyBytesSaved = local.keys.bytesSaved();
+      });
+    }
+    pool.waitForDone();
+
+    bool ok = true;
+    root->mChilds.reserve(count);
+    for (Chunk &chunk : chunks) {
+      if (context.arena)
+        context.arena->merge(chunk.arena);
+      for (QJsonTreeItem *child : std::as_const(chunk.items))
+        root->appendChild(child);
+      context.nodes += chunk.nodes;
+      context.keys.addSaved(chunk.keyBytesSaved);
+      if (ok && !chunk.ok) {
+        ok = false;
+        error.error = chunk.error;
+        error.offset = int(chunk.errorOffset);
+      }
+    }
+
+    if (!ok) {
+      if (!root->isArenaOwned())
+        delete root;
+      return nullptr;
+    }
+    if (split.isObject)
+      root->finishObject(context.keepKeyOrder);
+    return root;
+  }
+
+  //! Integers that fit stay exact, as with QJsonValue::toVariant(). Numbers
+  //! a double would round keep their text, which the writer emits verbatim.
+  static QJsonScalar numberValue(const char *text, qsizetype length,
+                                 bool isInteger) {
+    const QByteArray raw = QByteArray::fromRawData(text, length);
+    bool ok = false;
+    if (isInteger) {
+      const qint64 integer = raw.toLongLong(&ok);
+      // An integer has no negative zero; keep the sign of "-0" in a double
+      if (ok && integer == 0 && text[0] == '-')
+        return -0.0;
+      if (ok)
+        return integer;
+    }
+
+    int digits = 0;
+    bool leading = true;
+    for (qsizetype i = 0; i < length; ++i) {
+      const char c = text[i];
+      if (c == 'e' || c == 'E')
+        break;
+      if (!QJsonSax::isDigit(c) || (leading && c == '0'))
+        continue;
+      leading = false;
+      ++digits;
+    }
+
+    // Up to 15 significant digits always survive a double; longer numbers
+    // do when the shortest form of the double has the same value
+    const double d = raw.toDouble(&ok);
+    if (ok && (digits <= 15 ||
+               decimal(raw) ==
+                   decimal(QByteArray::number(
+                       d, 'e', QLocale::FloatingPointShortest))))
+      return d;
+    return {QString::fromLatin1(text, length), QJsonScalar::Number};
+  }
+
+  //! The value of a JSON number as its sign, its significant digits with no
+  //! leading or trailing zeros, and the power of ten before the first one.
+  //! Texts with the same decimal value give the same result.
+  static QByteArray decimal(const QByteArray &number) {
+    QByteArray digits;
+    qint64 exponent = 0;
+    bool point = false;
+    qsizetype i = 0;
+    for (; i < number.size(); ++i) {
+      const char c = number.at(i);
+      if (c == 'e' || c == 'E')
+        break;
+      if (c == '.') {
+        point = true;
+      } else if (QJsonSax::isDigit(c)) {
+        if (digits.isEmpty() && c == '0') {
+          exponent -= point;
+          continue;
+        }
+        digits += c;
+        exponent += !point;
+      }
+    }
+    while (digits.endsWith('0'))
+      digits.chop(1);
+    if (digits.isEmpty())
+      return number.startsWith('-') ? "-0" : "0";
+
+    if (i + 1 < number.size()) {
+      // Saturates: doubles of such exponents are infinite or zero anyway
+      const bool negative = number.at(i + 1) == '-';
+      qint64 power = 0;
+      for (++i; i < number.size(); ++i)
+        if (QJsonSax::isDigit(number.at(i)) && power < 100000)
+          power = power * 10 + (number.at(i) - '0');
+      exponent += negative ? -power : power;
+    }
+    return (number.startsWith('-') ? "-" : "") + digits + 'e' +
+           QByteArray::number(exponent);
+  }
+
+  bool push(QJsonValue::Type type) {
+    mStack.append(add(type));
+    if (mPathRules) {
+      mPaths.append(mChildPath);
+      mIndices.append(0);
+    }
+    return !mContext.cancelled();
+  }
+
+  QJsonTreeItem *pop() {
+    if (mPathRules) {
+      mPaths.removeLast();
+      mIndices.removeLast();
+    }
+    return mStack.takeLast();
+  }
+
+  //! Filter state of the container being filled.
+  const QJsonKeyFilter::State &path() const {
+    return mPaths.isEmpty() ? mContext.path : mPaths.last();
+  }
+
+  QJsonTreeItem *add(QJsonValue::Type type) {
+    const bool topLevel = mStack.isEmpty();
+    QJsonTreeItem *parent = topLevel ? mContainer : mStack.last();
+    QJsonTreeItem *item = QJsonTreeItem::create(parent, mContext.arena);
+    item->setType(type);
+    mContext.countNode();
+
+    if (!parent) {
+      item->setKey("root");
+      mRoot = item;
+    } else if (QJsonValue::Array == parent->type()) {
+      mContext.keys.skipIndex(topLevel ? mItems.size() : parent->childCount());
+    } else {
+      item->setKey(mContext.keys.intern(std::move(mKey)));
+    }
+
+    if (topLevel && mContainer)
+      mItems.append(item);
+    else if (parent)
+      parent->appendChild(item);
+    return item;
+  }
+
+  QJsonTreeItem::LoadContext &mContext;
+  QJsonTreeItem *mContainer;
+  //! Index of the next top-level element.
+  qsizetype mIndex;
+  QJsonTreeItem *mRoot = nullptr;
+  QList<QJsonTreeItem *> mItems;
+  QList<QJsonTreeItem *> mStack;
+  QString mKey;
+  //! Path rule state and next element index of each open container, kept
+  //! only when the filter has path rules.
+  bool mPathRules;
+  QList<QJsonKeyFilter::State> mPaths;
+  QList<qsizetype> mIndices;
+  QJsonKeyFilter::State mChildPath;
+};
+
+//=========================================================================
+
+inline uchar hexdig(uint u) { return (u < 0xa ? '0' + u : 'a' + u - 0xa); }
+
+//! Output bytes of the unit at \a src, which needs an escape or is a
+//! surrogate; advances \a src past it, and past the low half of a pair.
+static qsizetype escapedSize(const ushort *&src, const ushort *end) {
+  const uint u = *src++;
+  switch (u) {
+  case 0x22:
+  case 0x5c:
+  case 0x8:
+  case 0xc:
+  case 0xa:
+  case 0xd:
+  case 0x9:
+    return 2;
+  default:
+    break;
+  }
+  if (QChar::isHighSurrogate(u) && src != end && QChar::isLowSurrogate(*src)) {
+    ++src;
+    return 4;
+  }
+  return 6; // Other controls and lone surrogates
+}
+
+//! Appends the JSON escaped form of \a s to \a out. A first pass sizes the
+//! output exactly, so \a out grows once. Runs without escapes are found by
+//! the SIMD kernels of QJsonEscape and written in bulk: plain ASCII is
+//! narrowed directly, other text goes through QUtf8Functions::toUtf8Block().
+void appendEscaped(QByteArray &out, const QString &s) {
+  const ushort *const begin = reinterpret_cast<const ushort *>(s.constBegin());
+  const ushort *const end = reinterpret_cast<const ushort *>(s.constEnd());
+
+  qsizetype size = 0;
+  for (const ushort *src = begin; src != end;) {
+    const qsizetype plain = QJsonEscape::plainRun(src, end - src, nullptr);
+    size += plain;
+    src += plain;
+    if (src != end && *src >= 0x80 && !QChar::isSurrogate(*src)) {
+      const ushort *text = src + QJsonEscape::textRun(src, end - src);
+      size += QUtf8Functions::utf8Length(src, text);
+      src = text;
+    }
+    if (src != end)
+      size += escapedSize(src, end);
+  }
+
+  const qsizetype offset = out.size();
+  out.resize(offset + size);
+  uchar *cursor = reinterpret_cast<uchar *>(out.data()) + offset;
+  const ushort *src = begin;
+  while (src != end) {
+    const qsizetype plain = QJsonEscape::plainRun(src, end - src, cursor);
+    cursor += plain;
+    src += plain;
+    if (src == end)
+      break;
+    if (*src >= 0x80 && !QChar::isSurrogate(*src)) {
+      const ushort *text = src + QJsonEscape::textRun(src, end - src);
+      QUtf8Functions::toUtf8Block(src, text, cursor);
+      continue;
+    }
+
+    uint u = *src++;
+    if (u < 0x80) {
+      *cursor++ = '\\';
+      switch (u) {
+      case 0x22:
+        *cursor++ = '"';
+        break;
+      case 0x5c:
+        *cursor++ = '\\';
+        break;
+      case 0x8:
+        *cursor++ = 'b';
+        break;
+      case 0xc:
+        *cursor++ = 'f';
+        break;
+      case 0xa:
+        *cursor++ = 'n';
+        break;
+      case 0xd:
+        *cursor++ = 'r';
+        break;
+      case 0x9:
+        *cursor++ = 't';
+        break;
+      default:
+        *cursor++ = 'u';
+        *cursor++ = '0';
+        *cursor++ = '0';
+        *cursor++ = hexdig(u >> 4);
+        *cursor++ = hexdig(u & 0xf);
+      }
+    } else if (QUtf8Functions::toUtf8<QUtf8BaseTraits>(u, cursor, src, end) <
+               0) {
+      // failed to get valid utf8 use JSON escape sequence
+      *cursor++ = '\\';
+      *cursor++ = 'u';
+      *cursor++ = hexdig(u >> 12 & 0x0f);
+      *cursor++ = hexdig(u >> 8 & 0x0f);
+      *cursor++ = hexdig(u >> 4 & 0x0f);
+      *cursor++ = hexdig(u & 0x0f);
+    }
+  }
+  Q_ASSERT(cursor == reinterpret_cast<uchar *>(out.data()) + out.size());
+}
+
+//=========================================================================
+
+//! Serializes a QJsonTreeItem tree straight into \a buffer, without going
+//! through a QJsonValue DOM. When a device is given the buffer is flushed
+//! to it in chunks, so memory use does not depend on the document size.
+class QJsonTreeWriter {
+public:
+  QJsonTreeWriter(QByteArray &buffer, QIODevice *device, bool compact,
+                  const QJsonKeyFilter &filter)
+      : mBuffer(buffer), mDevice(device), mCompact(compact),
+        mFilter(filter) {
+    if (mDevice)
+      mBuffer.reserve(ChunkSize + ChunkSize / 4);
+  }
+
+  bool write(QJsonTreeItem *root) {
+    const bool isArray = QJsonValue::Array == root->type();
+    mBuffer += isArray ? '[' : '{';
+    if (!mCompact)
+      mBuffer += '\n';
+    writeContent(root, mCompact ? 0 : 1);
+    mBuffer += isArray ? ']' : '}';
+    if (!mCompact)
+      mBuffer += '\n';
+    flush();
+    return mOk;
+  }
+
+  qint64 bytesWritten() const { return mWritten + mBuffer.size(); }
+
+private:
+  static constexpr qsizetype ChunkSize = 64 * 1024;
+
+  void writeContent(QJsonTreeItem *item, int indent) {
+    const bool isObject = QJsonValue::Object == item->type();
+    bool first = true;
+    for (int i = 0; i < item->childCount() && mOk; ++i)
+      writeMember(item->child(i), isObject, indent, first);
+
+    // Children a lazy view never asked for are still in the source
+    if (item->canFetchMore()) {
+      for (auto ch : item->pendingChildren(mFilter)) {
+        writeMember(ch, isObject, indent, first);
+        delete ch;
+      }
+    }
+
+    if (!first && !mCompact)
+      mBuffer += '\n';
+  }
+
+  void writeMember(QJsonTreeItem *item, bool isObject, int indent,
+                   bool &first) {
+    if (!first)
+      mBuffer += mCompact ? "," : ",\n";
+    first = false;
+
+    mBuffer.append(4 * indent, ' ');
+    if (isObject) {
+      mBuffer += '"';
+      appendEscaped(mBuffer, item->key());
+      mBuffer += mCompact ? "\":" : "\": ";
+    }
+    writeValue(item, indent);
+
+    if (mDevice && mBuffer.size() >= ChunkSize)
+      flush();
+  }
+
+  void writeValue(QJsonTreeItem *item, int indent) {
+    const auto type = item->type();
+    if (QJsonValue::Array == type || QJsonValue::Object == type) {
+      const bool isArray = QJsonValue::Array == type;
+      mBuffer += isArray ? '[' : '{';
+      if (!mCompact)
+        mBuffer += '\n';
+      writeContent(item, indent + (mCompact ? 0 : 1));
+      mBuffer.append(4 * indent, ' ');
+      mBuffer += isArray ? ']' : '}';
+      return;
+    }
+
+    const QJsonScalar &value = item->scalar();
+    switch (value.kind()) {
+    case QJsonScalar::Bool:
+      mBuffer += value.toBool() ? "true" : "false";
+      break;
+    case QJsonScalar::Integer:
+      mBuffer += QByteArray::number(value.toInteger());
+      break;
+    case QJsonScalar::Double: {
+      const double d = value.toDouble();
+      if (qIsFinite(d))
+        mBuffer += QByteArray::number(d, 'f', QLocale::FloatingPointShortest);
+      else
+        mBuffer += "null"; // +INF || -INF || NaN (see RFC4627#section2.4)
+      break;
+    }
+    case QJsonScalar::Number:
+      // Numbers too precise for a double keep their original text
+      mBuffer += value.text().toLatin1();
+      break;
+    case QJsonScalar::String:
+      mBuffer += '"';
+      appendEscaped(mBuffer, value.text());
+      mBuffer += '"';
+      break;
+    default:
+      mBuffer += "null";
+    }
+  }
+
+  void flush() {
+    if (!mDevice || mBuffer.isEmpty())
+      return;
+    if (mDevice->write(mBuffer) != mBuffer.size())
+      mOk = false;
+    mWritten += mBuffer.size();
+    // resize() keeps the capacity, so the chunk buffer is reused
+    mBuffer.resize(0);
+  }
+
+  QByteArray &mBuffer;
+  QIODevice *mDevice;
+  bool mCompact;
+  const QJsonKeyFilter &mFilter;
+  bool mOk = true;
+  qint64 mWritten = 0;
+};
+
+//! Writes the tree under \a item to \a writer as CBOR, with definite
+//! lengths. Numbers kept as text go out as integers when they are ones,
+//! as doubles otherwise.
+static void writeCbor(QCborStreamWriter &writer, QJsonTreeItem *item,
+                      const QJsonKeyFilter &filter) {
+  const auto type = item->type();
+  if (QJsonValue::Array == type || QJsonValue::Object == type) {
+    const bool isObject = QJsonValue::Object == type;
+    // Children a lazy view never asked for are still in the source
+    const QList<QJsonTreeItem *> pending = item->canFetchMore()
+                                               ? item->pendingChildren(filter)
+                                               : QList<QJsonTreeItem *>();
+    const quint64 count = quint64(item->childCount() + pending.size());
+    if (isObject)
+      writer.startMap(count);
+    else
+      writer.startArray(count);
+    for (int i = 0; i < item->childCount() + int(pending.size()); ++i) {
+      QJsonTreeItem *child = i < item->childCount()
+                                 ? item->child(i)
+                                 : pending.at(i - item->childCount());
+      if (isObject)
+        writer.append(child->key());
+      writeCbor(writer, child, filter);
+    }
+    qDeleteAll(pending);
+    if (isObject)
+      writer.endMap();
+    else
+      writer.endArray();
+    return;
+  }
+
+  const QJsonScalar &value = item->scalar();
+  switch (value.kind()) {
+  case QJsonScalar::Bool:
+    writer.append(value.toBool());
+    break;
+  case QJsonScalar::Integer:
+    writer.append(value.toInteger());
+    break;
+  case QJsonScalar::Double:
+    writer.append(value.toDouble());
+    break;
+  case QJsonScalar::Number: {
+    const QString &text = value.text();
+    bool ok = false;
+    const quint64 magnitude =
+        (text.startsWith(u'-') ? text.mid(1) : text).toULongLong(&ok);
+    if (text == QLatin1String("-18446744073709551616"))
+      writer.append(QCborNegativeInteger(0)); // -2^64, CBOR's smallest
+    else if (!ok)
+      writer.append(value.toDouble());
+    else if (text.startsWith(u'-'))
+      writer.append(QCborNegativeInteger(magnitude));
+    else
+      writer.append(magnitude);
+    break;
+  }
+  case QJsonScalar::String:
+    writer.append(value.text());
+    break;
+  default:
+    writer.appendNull();
+  }
+}
+
+//=========================================================================
+
+//! Builds the model tree for \a json, as loadJson() does: with the native
+//! parser, or from a QJsonDocument kept as the source of a lazy tree. The
+//! phases are timed into \a statistics when given.
+static QJsonTreeItem *parseTree(const QByteArray &json,
+                                QJsonTreeItem::LoadContext &context,
+                                bool lazy, QJsonParseError &error,
+                                QJsonModelStatistics *statistics = nullptr) {
+  QElapsedTimer timer;
+  if (statistics) {
+    statistics->parseNs = 0;
+    statistics->buildNs = 0;
+    statistics->loadedBytes = json.size();
+    timer.start();
+  }
+
+  if (!lazy) {
+    QJsonTreeItem *root = QJsonTreeBuilder::parse(json, context, error);
+    if (statistics)
+      statistics->buildNs = timer.nsecsElapsed();
+    return root;
+  }
+
+  const QJsonDocument jdoc = QJsonDocument::fromJson(json, &error);
+  if (statistics) {
+    statistics->parseNs = timer.nsecsElapsed();
+    timer.start();
+  }
+  if (jdoc.isNull())
+    return nullptr;
+  QJsonTreeItem *root = QJsonTreeItem::loadLazy(
+      jdoc.isArray() ? QJsonValue(jdoc.array()) : QJsonValue(jdoc.object()));
+  if (statistics)
+    statistics->buildNs = timer.nsecsElapsed();
+  return root;
+}
+
+//! Maps the whole of \a file and wraps the mapping without copying it. The
+//! result is only valid while \a file stays open; it is null when the file
+//! cannot be mapped (empty, or not a regular file).
+static QByteArray mapFile(QFile &file) {
+  const qint64 size = file.size();
+  if (size <= 0)
+    return {};
+
+  uchar *data = file.map(0, size);
+  if (!data)
+    return {};
+
+  return QByteArray::fromRawData(reinterpret_cast<const char *>(data), size);
+}
+
+//! Writes the snapshot of the tree under \a root, taken from \a source, to
+//! \a device. Children a lazy view has not fetched yet are built for the
+//! snapshot only, skipping those \a filter excludes.
+static bool writeSnapshot(QJsonTreeItem *root, const QJsonKeyFilter &filter,
+                          const QFileInfo &source, QIODevice *device) {
+  using namespace QJsonSnapshot;
+  std::vector<Node> nodes;
+  std::vector<StringRef> strings;
+  std::vector<char16_t> units;
+  QHash<QString, quint32> stringIndex;
+  auto intern = [&](const QString &text) {
+    const auto it = stringIndex.constFind(text);
+    if (it != stringIndex.constEnd())
+      return *it;
+    const quint32 index = quint32(strings.size());
+    strings.push_back({quint64(units.size()), quint64(text.size())});
+    units.insert(units.end(), text.utf16(), text.utf16() + text.size());
+    stringIndex.insert(text, index);
+    return index;
+  };
+
+  std::vector<std::unique_ptr<QJsonTreeItem>> pending;
+  QList<QJsonTreeItem *> queue{root};
+  for (qsizetype i = 0; i < queue.size(); ++i) {
+    QJsonTreeItem *item = queue.at(i);
+    Node node{};
+    node.type = quint8(item->type());
+    const QJsonScalar &value = item->scalar();
+    node.kind = quint8(value.kind());
+    switch (value.kind()) {
+    case QJsonScalar::Bool:
+      node.value = value.toBool();
+      break;
+    case QJsonScalar::Integer:
+      node.value = quint64(value.toInteger());
+      break;
+    case QJsonScalar::Double: {
+      const double d = value.toDouble();
+      std::memcpy(&node.value, &d, sizeof(d));
+      break;
+    }
+    case QJsonScalar::Number:
+    case QJsonScalar::String:
+      node.value = intern(value.text());
+      break;
+    default:
+      break;
+    }
+    // Array elements take their key from their row, unless they were given
+    // one of their own, such as the number of a JSON Lines record
+    QJsonTreeItem *parent = item->parent();
+    if (!parent || QJsonValue::Array != parent->type() ||
+        item->key() != QString::number(item->row()))
+      node.key = intern(item->key()) + 1;
+
+    node.firstChild = quint32(queue.size());
+    for (int row = 0; row < item->childCount(); ++row)
+      queue.append(item->child(row));
+    if (item->canFetchMore()) {
+      for (QJsonTreeItem *child : item->pendingChildren(filter)) {
+        pending.emplace_back(child);
+        queue.append(child);
+      }
+    }
+    node.childCount = quint32(queue.size() - node.firstChild);
+    nodes.push_back(node);
+  }
+  if (queue.size() > std::numeric_limits<quint32>::max())
+    return false;
+
+  Header header{};
+  header.magic = Magic;
+  header.version = Version;
+  header.sourceSize = source.size();
+  header.sourceModified = source.lastModified().toMSecsSinceEpoch();
+  header.stringCount = strings.size();
+  header.stringDataSize = units.size();
+  header.nodeCount = nodes.size();
+  // Pads the string data up to the node table
+  units.resize(units.size() + (4 - units.size() % 4) % 4, 0);
+
+  const qsizetype stringBytes = strings.size() * sizeof(StringRef);
+  const qsizetype unitBytes = units.size() * sizeof(char16_t);
+  const qsizetype nodeBytes = nodes.size() * sizeof(Node);
+  header.checksum = checksum(
+      nodes.data(), nodeBytes,
+      checksum(units.data(), unitBytes, checksum(strings.data(), stringBytes)));
+
+  return device->write(reinterpret_cast<const char *>(&header),
+                       sizeof(header)) == qint64(sizeof(header)) &&
+         device->write(reinterpret_cast<const char *>(strings.data()),
+                       stringBytes) == stringBytes &&
+         device->write(reinterpret_cast<const char *>(units.data()),
+                       unitBytes) == unitBytes &&
+         device->write(reinterpret_cast<const char *>(nodes.data()),
+                       nodeBytes) == nodeBytes;
+}
+
+//! Rebuilds the tree held by the snapshot \a data in \a arena. Returns null
+//! if the snapshot is damaged, of another version, or was not taken from
+//! \a source as it is now.
+static QJsonTreeItem *readSnapshot(const QByteArray &data,
+                                   const QFileInfo &source,
+                                   QJsonTreeArena &arena,
+                                   qint64 &keyBytesSaved) {
+  using namespace QJsonSnapshot;
+  const quint64 size = quint64(data.size());
+  Header header;
+  if (size < sizeof(header))
+    return nullptr;
+  std::memcpy(&header, data.constData(), sizeof(header));
+  if (header.magic != Magic || header.version != Version ||
+      !source.exists() || header.sourceSize != source.size() ||
+      header.sourceModified != source.lastModified().toMSecsSinceEpoch())
+    return nullptr;
+  // Bounded by the file size first, so that the offsets cannot overflow
+  if (header.stringCount > size / sizeof(StringRef) ||
+      header.stringDataSize > size / sizeof(char16_t) ||
+      header.nodeCount == 0 || header.nodeCount > size / sizeof(Node) ||
+      header.nodeCount > std::numeric_limits<quint32>::max())
+    return nullptr;
+  const Sections sections(header);
+  if (sections.end != size ||
+      checksum(data.constData() + sizeof(header), size - sizeof(header)) !=
+          header.checksum)
+    return nullptr;
+
+  // Every distinct string is built once; the nodes share them
+  QList<QString> strings;
+  strings.reserve(header.stringCount);
+  const QChar *units =
+      reinterpret_cast<const QChar *>(data.constData() + sections.stringData);
+  for (quint64 i = 0; i < header.stringCount; ++i) {
+    StringRef ref;
+    std::memcpy(&ref, data.constData() + sections.strings + i * sizeof(ref),
+                sizeof(ref));
+    if (ref.offset > header.stringDataSize ||
+        ref.length > header.stringDataSize - ref.offset)
+      return nullptr;
+    strings.append(QString(units + ref.offset, qsizetype(ref.length)));
+  }
+
+  const qsizetype count = qsizetype(header.nodeCount);
+  QList<Node> nodes(count);
+  std::memcpy(nodes.data(), data.constData() + sections.nodes,
+              count * sizeof(Node));
+
+  // Breadth-first order: every node but the root is a child of an earlier
+  // one, and children follow each other
+  quint64 next = 1;
+  for (qsizetype i = 0; i < count; ++i) {
+    const Node &node = nodes.at(i);
+    const bool text = node.kind == QJsonScalar::Number ||
+                      node.kind == QJsonScalar::String;
+    const bool knownType =
+        node.type <= QJsonValue::Object || node.type == QJsonValue::Undefined;
+    if ((i > 0 && quint64(i) >= next) || !knownType ||
+        node.kind > QJsonScalar::String ||
+        node.key > header.stringCount ||
+        (text && node.value >= header.stringCount) ||
+        (node.childCount && node.firstChild != next))
+      return nullptr;
+    next += node.childCount;
+  }
+  if (next != header.nodeCount)
+    return nullptr;
+
+  QList<QJsonTreeItem *> items(count);
+  QList<bool> seen(header.stringCount, false);
+  for (qsizetype i = 0; i < count; ++i) {
+    const Node &node = nodes.at(i);
+    QJsonTreeItem *item = QJsonTreeItem::create(nullptr, &arena);
+    item->setType(QJsonValue::Type(node.type));
+    if (node.key) {
+      const QString &key = strings.at(node.key - 1);
+      if (std::exchange(seen[node.key - 1], true))
+        keyBytesSaved += QJsonKeyPool::stringBytes(key.size());
+      item->setKey(key);
+    }
+    switch (node.kind) {
+    case QJsonScalar::Null:
+      item->setScalar(nullptr);
+      break;
+    case QJsonScalar::Bool:
+      item->setScalar(node.value != 0);
+      break;
+    case QJsonScalar::Integer:
+      item->setScalar(qint64(node.value));
+      break;
+    case QJsonScalar::Double: {
+      double d;
+      std::memcpy(&d, &node.value, sizeof(d));
+      item->setScalar(d);
+      break;
+    }
+    case QJsonScalar::Number:
+      item->setScalar({strings.at(node.value), QJsonScalar::Number});
+      break;
+    case QJsonScalar::String:
+      item->setScalar(strings.at(node.value));
+      break;
+    default:
+      break;
+    }
+    items[i] = item;
+  }
+  for (qsizetype i = 0; i < count; ++i) {
+    const Node &node = nodes.at(i);
+    if (node.childCount)
+      items.at(i)->insertChildren(0, items.mid(node.firstChild,
+                                               node.childCount));
+  }
+  return items.first();
+}
+
+//! Adds the keys and scalar values of the tree under \a root to \a index.
+//! Array indices are not indexed: they are only the row.
+static void indexTree(QJsonTreeItem *root, QJsonSearchIndex &index) {
+  QList<QJsonTreeItem *> stack{root};
+  while (!stack.isEmpty()) {
+    QJsonTreeItem *item = stack.takeLast();
+    for (int i = item->childCount() - 1; i >= 0; --i)
+      stack.append(item->child(i));
+
+    QJsonTreeItem *parent = item->parent();
+    if (parent && QJsonValue::Array != parent->type())
+      index.add(item, item->key());
+    if (!item->childCount() && QJsonValue::Array != item->type() &&
+        QJsonValue::Object != item->type())
+      index.add(item, item->scalar().toString());
+  }
+}
+
+//! Sets the node counts and byte estimates of \a statistics from the tree
+//! under \a root.
+static void measureTree(QJsonTreeItem *root,
+                        QJsonModelStatistics &statistics) {
+  statistics.objects = statistics.arrays = statistics.strings = 0;
+  statistics.numbers = statistics.bools = statistics.nulls = 0;
+  statistics.keyBytes = statistics.valueBytes = statistics.nodeBytes = 0;
+  statistics.depth = 0;
+
+  // Pooled keys share their data, which is what gets counted
+  QSet<const QChar *> keys;
+  QList<QPair<QJsonTreeItem *, int>> stack{{root, 0}};
+  while (!stack.isEmpty()) {
+    QJsonTreeItem *item = stack.last().first;
+    const int depth = stack.takeLast().second;
+    statistics.depth = qMax<qint64>(statistics.depth, depth);
+    for (int i = item->childCount() - 1; i >= 0; --i)
+      stack.append({item->child(i), depth + 1});
+
+    statistics.nodeBytes += item->nodeBytes();
+    QJsonTreeItem *parent = item->parent();
+    if (parent && QJsonValue::Array != parent->type()) {
+      const QString key = item->key();
+      if (!key.isEmpty() && !keys.contains(key.constData())) {
+        keys.insert(key.constData());
+        statistics.keyBytes += QJsonKeyPool::stringBytes(key.size());
+      }
+    }
+
+    // Other scalars live in the node itself
+    const QString &text = item->scalar().text();
+    if (!text.isNull())
+      statistics.valueBytes += QJsonKeyPool::stringBytes(text.size());
+
+    switch (item->type()) {
+    case QJsonValue::Object:
+      ++statistics.objects;
+      break;
+    case QJsonValue::Array:
+      ++statistics.arrays;
+      break;
+    case QJsonValue::String:
+      ++statistics.strings;
+      break;
+    case QJsonValue::Double:
+      ++statistics.numbers;
+      break;
+    case QJsonValue::Bool:
+      ++statistics.bools;
+      break;
+    default:
+      ++statistics.nulls;
+    }
+  }
+}
+
+//! State of a loadAsync() run, shared between the model and its worker.
+struct QJsonModel::AsyncLoad {
+  QString fileName;
+  QJsonKeyFilter filter;
+  bool lazy = false;
+  //! Build on the heap, since the result is merged into the current tree
+  bool incremental = false;
+  bool keepKeyOrder = false;
+  bool memoryMapping = false;
+  bool searchIndex = false;
+  bool measure = false;
+  int threads = 1;
+  qsizetype parallelThreshold = 0;
+  std::atomic_bool cancel{false};
+  //! Result, handed over to the model once the worker is done
+  QJsonTreeArena arena;
+  QJsonTreeItem *root = nullptr;
+  QJsonParseError error;
+  qint64 keyBytesSaved = 0;
+  QJsonSearchIndex index;
+  //! Phase timings, when measure is set
+  QJsonModelStatistics statistics;
+
+  ~AsyncLoad() {
+    if (root && !root->isArenaOwned())
+      delete root;
+    QJsonTreeItem::destroyArena(arena);
+  }
+
+  void run(QJsonModel *model) {
+    static constexpr qint64 ChunkSize = 1024 * 1024;
+
+    QElapsedTimer timer;
+    if (measure)
+      timer.start();
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+      return;
+
+    const qint64 total = file.size();
+    QByteArray json = memoryMapping ? mapFile(file) : QByteArray();
+    if (!json.isNull()) {
+      emit model->loadProgress(total, total, 0);
+    } else {
+      json.reserve(total);
+      while (!file.atEnd()) {
+        if (cancel)
+          return;
+        const QByteArray chunk = file.read(ChunkSize);
+        if (chunk.isEmpty())
+          break;
+        json += chunk;
+        emit model->loadProgress(json.size(), total, 0);
+      }
+      file.close();
+    }
+
+    if (cancel)
+      return;
+    if (measure)
+      statistics.readNs = timer.nsecsElapsed();
+
+    QJsonTreeItem::LoadContext context{filter,
+                                       incremental ? nullptr : &arena};
+    context.path = filter.rootState();
+    context.cancel = &cancel;
+    context.keepKeyOrder = keepKeyOrder;
+    context.threads = threads;
+    context.parallelThreshold = parallelThreshold;
+    context.progress = [model, total](qint64 nodes) {
+      emit model->loadProgress(total, total, nodes);
+    };
+    root = parseTree(json, context, lazy, error,
+                     measure ? &statistics : nullptr);
+    keyBytesSaved = context.keys.bytesSaved();
+    // A tree that will be merged is not the one searches will see
+    if (root && searchIndex && !incremental && !cancel)
+      indexTree(root, index);
+    if (root && !cancel)
+      emit model->loadProgress(total, total, context.nodes);
+  }
+};
+
+//! A find() run, shared between the model and its workers.
+struct QJsonModel::Search {
+  static constexpr qsizetype BatchSize = 256;
+
+  Search(int id, const QString &pattern, Qt::MatchFlags flags)
+      : id(id), pattern(pattern), mode(int(flags & Qt::MatchTypeMask)),
+        sensitivity(flags.testFlag(Qt::MatchCaseSensitive)
+                        ? Qt::CaseSensitive
+                        : Qt::CaseInsensitive) {
+    if (Qt::MatchWildcard == mode || Qt::MatchRegularExpression == mode) {
+      const QString expression =
+          Qt::MatchWildcard == mode
+              ? QRegularExpression::wildcardToRegularExpression(pattern)
+              : pattern;
+      regex.setPattern(expression);
+      if (Qt::CaseInsensitive == sensitivity)
+        regex.setPatternOptions(QRegularExpression::CaseInsensitiveOption);
+      regex.optimize();
+    }
+  }
+
+  //! Whether every match contains the pattern as is, so the trigram index
+  //! can narrow the candidates.
+  bool indexable() const {
+    return mode != Qt::MatchWildcard && mode != Qt::MatchRegularExpression &&
+           pattern.size() >= QJsonSearchIndex::MinimumLength;
+  }
+
+  bool matches(const QString &text) const {
+    switch (mode) {
+    case Qt::MatchContains:
+      return text.contains(pattern, sensitivity);
+    case Qt::MatchStartsWith:
+      return text.startsWith(pattern, sensitivity);
+    case Qt::MatchEndsWith:
+      return text.endsWith(pattern, sensitivity);
+    case Qt::MatchWildcard:
+    case Qt::MatchRegularExpression:
+      return regex.match(text).hasMatch();
+    default:
+      return text.compare(pattern, sensitivity) == 0;
+    }
+  }
+
+  bool matches(QJsonTreeItem *item) const {
+    QJsonTreeItem *parent = item->parent();
+    if (parent && QJsonValue::Array != parent->type() && matches(item->key()))
+      return true;
+    if (QJsonValue::Array == item->type() || QJsonValue::Object == item->type())
+      return false;
+    return matches(item->scalar().toString());
+  }
+
+  //! Checks \a items, and their subtrees when \a descend, handing matches
+  //! to \a post in batches.
+  template <typename Post>
+  void scan(const QList<QJsonTreeItem *> &items, bool descend,
+            const Post &post) const {
+    QList<QJsonTreeItem *> batch;
+    QList<QJsonTreeItem *> stack;
+    for (QJsonTreeItem *item : items) {
+      stack.append(item);
+      while (!stack.isEmpty()) {
+        if (cancel.load(std::memory_order_relaxed))
+          return;
+        QJsonTreeItem *current = stack.takeLast();
+        if (descend)
+          for (int i = current->childCount() - 1; i >= 0; --i)
+            stack.append(current->child(i));
+        if (!matches(current))
+          continue;
+        batch.append(current);
+        if (batch.size() == BatchSize)
+          post(std::exchange(batch, {}));
+      }
+    }
+    if (!batch.isEmpty())
+      post(batch);
+  }
+
+  const int id;
+  const QString pattern;
+  const int mode;
+  const Qt::CaseSensitivity sensitivity;
+  QRegularExpression regex;
+  std::atomic_bool cancel{false};
+  //! Worker tasks still running; the last one to finish reports it.
+  std::atomic<int> pending{0};
+  //! Matches delivered so far, counted on the model thread.
+  qint64 found = 0;
+};
+
+//! Undo steps of a QJsonModel. Edits point at the nodes they touched: the
+//! nodes an edit detached stay alive, owned by the history, as long as the
+//! edit may be replayed.
+struct QJsonModel::UndoHistory {
+  struct Edit {
+    enum Kind { SetValue, Insert, Remove, Move };
+    Kind kind = SetValue;
+    //! Parent of the inserted or removed rows, or where moved rows were.
+    QJsonTreeItem *from = nullptr;
+    //! Where moved rows went.
+    QJsonTreeItem *to = nullptr;
+    //! First row in from, and first row in to once moved.
+    int row = 0;
+    int target = 0;
+    //! The edited item, or the inserted, removed or moved ones.
+    QList<QJsonTreeItem *> items;
+    QJsonScalar before;
+    QJsonScalar after;
+    //! Null items take the type of the first value they are given.
+    QJsonValue::Type typeBefore = QJsonValue::Null;
+    QJsonValue::Type typeAfter = QJsonValue::Null;
+    //! Keys of moved items in from and in to; empty in arrays.
+    QStringList fromKeys;
+    QStringList toKeys;
+  };
+  using Step = QList<Edit>;
+
+  ~UndoHistory() { clear(); }
+
+  //! Deletes the nodes only \a step still holds: those its removals
+  //! detached if it is \a applied, those its insertions added otherwise.
+  static void release(const Step &step, bool applied) {
+    for (const Edit &edit : step) {
+      if (edit.kind != (applied ? Edit::Remove : Edit::Insert))
+        continue;
+      for (QJsonTreeItem *item : edit.items)
+        if (!item->parent() && !item->isArenaOwned())
+          delete item;
+    }
+  }
+
+  void record(Edit &&edit) {
+    for (const Step &step : std::as_const(undone))
+      release(step, false);
+    undone.clear();
+    open.append(std::move(edit));
+  }
+
+  //! Closes the open step, dropping the oldest ones beyond the limit.
+  void close() {
+    if (open.isEmpty())
+      return;
+    done.append(std::exchange(open, {}));
+    while (done.size() > limit)
+      release(done.takeFirst(), true);
+  }
+
+  void clear() {
+    release(open, true);
+    for (const Step &step : std::as_const(done))
+      release(step, true);
+    for (const Step &step : std::as_const(undone))
+      release(step, false);
+    open.clear();
+    done.clear();
+    undone.clear();
+  }
+
+  int limit = 0;
+  //! Edits since the last snapshot().
+  Step open;
+  QList<Step> done;
+  QList<Step> undone;
+  //! Set while undo() or redo() run the edits, which are not recorded.
+  bool replaying = false;
+  //! Last states reported by canUndoChanged() and canRedoChanged().
+  bool couldUndo = false;
+  bool couldRedo = false;
+};
+
+QJsonModel::QJsonModel(QObject *parent)
+    : QAbstractItemModel(parent), mRootItem{new QJsonTreeItem} {
+  mHeaders.append("key");
+  mHeaders.append("value");
+
+  // Searches read the tree from worker threads: stop them before it changes
+  connect(this, &QAbstractItemModel::modelAboutToBeReset, this,
+          &QJsonModel::invalidateSearch);
+  connect(this, &QAbstractItemModel::rowsAboutToBeInserted, this,
+          &QJsonModel::invalidateSearch);
+  connect(this, &QAbstractItemModel::rowsAboutToBeRemoved, this,
+          &QJsonModel::invalidateSearch);
+  connect(this, &QAbstractItemModel::rowsAboutToBeMoved, this,
+          &QJsonModel::invalidateSearch);
+}
+
+QJsonModel::QJsonModel(const QString &fileName, QObject *parent)
+    : QJsonModel(parent) {
+  load(fileName);
+}
+
+QJsonModel::QJsonModel(QIODevice *device, QObject *parent)
+    : QJsonModel(parent) {
+  load(device);
+}
+
+QJsonModel::QJsonModel(const QByteArray &json, QObject *parent)
+    : QJsonModel(parent) {
+  loadJson(json);
+}
+
+QJsonModel::~QJsonModel() {
+  cancelFind();
+  if (mLoadThread) {
+    mAsyncLoad->cancel = true;
+    mLoadThread->wait();
+    delete mLoadThread;
+  }
+  releaseTree();
+}
+
+void QJsonModel::setLazyLoading(bool enabled) { mLazyLoading = enabled; }
+
+bool QJsonModel::lazyLoading() const { return mLazyLoading; }
+
+void QJsonModel::setFetchBatchSize(int size) {
+  mFetchBatchSize = qMax(1, size);
+}
+
+int QJsonModel::fetchBatchSize() const { return mFetchBatchSize; }
+
+void QJsonModel::setPreserveKeyOrder(bool enabled) {
+  mPreserveKeyOrder = enabled;
+}
+
+bool QJsonModel::preserveKeyOrder() const { return mPreserveKeyOrder; }
+
+void QJsonModel::setMemoryMapping(bool enabled) { mMemoryMapping = enabled; }
+
+bool QJsonModel::memoryMapping() const { return mMemoryMapping; }
+
+void QJsonModel::setParallelThreshold(int children) {
+  mParallelThreshold = qMax(1, children);
+}
+
+int QJsonModel::parallelThreshold() const { return mParallelThreshold; }
+
+void QJsonModel::setLoadThreadCount(int threads) {
+  mLoadThreadCount = qMax(0, threads);
+}
+
+int QJsonModel::loadThreadCount() const { return mLoadThreadCount; }
+
+void QJsonModel::configure(QJsonTreeItem::LoadContext &context) const {
+  context.threads =
+      mLoadThreadCount > 0 ? mLoadThreadCount : QThread::idealThreadCount();
+  context.parallelThreshold = mParallelThreshold;
+  context.keepKeyOrder = mPreserveKeyOrder;
+  context.path = mFilter.rootState();
+}
+
+QJsonParseError QJsonModel::parseError() const { return mParseError; }
+
+bool QJsonModel::load(const QString &fileName) {
+  QFile file(fileName);
+  bool success = false;
+  if (file.open(QIODevice::ReadOnly)) {
+    // The parser reads the page cache directly; nothing keeps pointing into
+    // the mapping after loadJson() returns, so closing unmaps it safely.
+    QElapsedTimer timer;
+    if (mStatisticsEnabled)
+      timer.start();
+    const QByteArray mapped = mMemoryMapping ? mapFile(file) : QByteArray();
+    if (mStatisticsEnabled)
+      mReadNs = timer.nsecsElapsed();
+    success = mapped.isNull() ? load(&file) : loadJson(mapped);
+    file.close();
+  } else {
+    success = false;
+  }
+
+  return success;
+}
+
+bool QJsonModel::saveSnapshot(const QString &fileName,
+                              const QString &sourceFile) {
+  const QFileInfo source(sourceFile);
+  if (!mRootItem || !source.exists())
+    return false;
+
+  // Written aside: a reader never sees half a snapshot
+  QSaveFile file(fileName);
+  if (!file.open(QIODevice::WriteOnly))
+    return false;
+  if (!writeSnapshot(mRootItem, mFilter, source, &file)) {
+    file.cancelWriting();
+    return false;
+  }
+  return file.commit();
+}
+
+bool QJsonModel::loadSnapshot(const QString &fileName,
+                              const QString &sourceFile) {
+  cancelLoad();
+  QFile file(fileName);
+  if (!file.open(QIODevice::ReadOnly))
+    return false;
+
+  QJsonModelStatistics *statistics =
+      mStatisticsEnabled ? &mStatistics : nullptr;
+  QElapsedTimer timer;
+  if (statistics)
+    timer.start();
+  // Strings are copied out, so nothing points into the mapping afterwards
+  QByteArray data = mapFile(file);
+  if (data.isNull())
+    data = file.readAll();
+  if (statistics) {
+    statistics->readNs = timer.nsecsElapsed();
+    statistics->parseNs = 0;
+    statistics->loadedBytes = data.size();
+    timer.start();
+  }
+
+  QJsonTreeArena arena;
+  qint64 keyBytesSaved = 0;
+  QJsonTreeItem *root =
+      readSnapshot(data, QFileInfo(sourceFile), arena, keyBytesSaved);
+  if (!root) {
+    QJsonTreeItem::destroyArena(arena);
+    qDebug() << Q_FUNC_INFO << "cannot use snapshot" << fileName << "of"
+             << sourceFile;
+    return false;
+  }
+
+  if (statistics) {
+    statistics->buildNs = timer.nsecsElapsed();
+    timer.start();
+  }
+  if (installTree(root, arena, false) && mSearchIndexEnabled)
+    rebuildSearchIndex();
+  mKeyBytesSaved = keyBytesSaved;
+  if (statistics) {
+    statistics->installNs = timer.nsecsElapsed();
+    reportStatistics();
+  }
+  return true;
+}
+
+bool QJsonModel::load(QIODevice *device, Format format) {
+  QElapsedTimer timer;
+  if (mStatisticsEnabled)
+    timer.start();
+  const QByteArray data = device->readAll();
+  if (mStatisticsEnabled)
+    mReadNs = timer.nsecsElapsed();
+  return Format::Cbor == format ? loadCbor(data) : loadJson(data);
+}
+
+bool QJsonModel::loadJson(const QByteArray &json) {
+  cancelLoad();
+
+  // Build aside so that a failed load leaves the current tree untouched.
+  // A tree about to be merged is built on the heap: its unchanged nodes are
+  // freed right away instead of piling up in the model arena.
+  const bool incremental = canMerge();
+  QJsonTreeArena arena;
+  QJsonTreeItem::LoadContext context{mFilter,
+                                     incremental ? nullptr : &arena};
+  configure(context);
+  QJsonModelStatistics *statistics =
+      mStatisticsEnabled ? &mStatistics : nullptr;
+  if (statistics)
+    statistics->readNs = mReadNs;
+  mReadNs = 0;
+  QJsonTreeItem *root =
+      parseTree(json, context, mLazyLoading, mParseError, statistics);
+
+  if (root) {
+    QElapsedTimer timer;
+    if (statistics)
+      timer.start();
+    if (installTree(root, arena, mLazyLoading) && mSearchIndexEnabled)
+      rebuildSearchIndex();
+    mKeyBytesSaved = context.keys.bytesSaved();
+    if (statistics) {
+      statistics->installNs = timer.nsecsElapsed();
+      reportStatistics();
+    }
+    return true;
+  }
+
+  QJsonTreeItem::destroyArena(arena);
+  qDebug() << Q_FUNC_INFO << "cannot load json:" << mParseError.errorString()
+           << "at offset" << mParseError.offset;
+  return false;
+}
+
+bool QJsonModel::loadCbor(const QByteArray &cbor) {
+  cancelLoad();
+
+  // Same as loadJson(), except that there is no lazy path: CBOR has no
+  // QJsonDocument to keep as the source of unbuilt children.
+  const bool incremental = canMerge();
+  QJsonTreeArena arena;
+  QJsonTreeItem::LoadContext context{mFilter,
+                                     incremental ? nullptr : &arena};
+  configure(context);
+  QJsonModelStatistics *statistics =
+      mStatisticsEnabled ? &mStatistics : nullptr;
+  QElapsedTimer timer;
+  if (statistics) {
+    statistics->readNs = mReadNs;
+    statistics->parseNs = 0;
+    statistics->loadedBytes = cbor.size();
+    timer.start();
+  }
+  mReadNs = 0;
+  QCborParserError error;
+  QJsonTreeItem *root = QJsonTreeBuilder::parseCbor(cbor, context, error);
+  if (statistics)
+    statistics->buildNs = timer.nsecsElapsed();
+
+  if (root) {
+    if (statistics)
+      timer.start();
+    if (installTree(root, arena, false) && mSearchIndexEnabled)
+      rebuildSearchIndex();
+    mKeyBytesSaved = context.keys.bytesSaved();
+    if (statistics) {
+      statistics->installNs = timer.nsecsElapsed();
+      reportStatistics();
+    }
+    return true;
+  }
+
+  QJsonTreeItem::destroyArena(arena);
+  qDebug() << Q_FUNC_INFO << "cannot load cbor:" << error.errorString()
+           << "at offset" << error.offset;
+  return false;
+}
+
+bool QJsonModel::loadAsync(const QString &fileName) {
+  if (!QFile::exists(fileName))
+    return false;
+
+  if (mLoadThread) {
+    // Only one worker at a time, so none can outlive the model
+    mAsyncLoad->cancel = true;
+    mLoadThread->wait();
+    delete mLoadThread;
+  }
+
+  auto state = std::make_shared<AsyncLoad>();
+  state->fileName = fileName;
+  state->filter = mFilter;
+  state->lazy = mLazyLoading;
+  state->incremental = canMerge();
+  state->searchIndex = mSearchIndexEnabled;
+  state->measure = mStatisticsEnabled;
+  state->memoryMapping = mMemoryMapping;
+  QJsonTreeItem::LoadContext settings{mFilter};
+  configure(settings);
+  state->keepKeyOrder = settings.keepKeyOrder;
+  state->threads = settings.threads;
+  state->parallelThreshold = settings.parallelThreshold;
+  mAsyncLoad = state;
+
+  QThread *thread = QThread::create([state, this] { state->run(this); });
+  mLoadThread = thread;
+  connect(thread, &QThread::finished, this, [this, state, thread] {
+    // A superseded worker has already been deleted by loadAsync()
+    if (state != mAsyncLoad)
+      return;
+    mAsyncLoad.reset();
+    mLoadThread = nullptr;
+    thread->deleteLater();
+    mParseError = state->error;
+
+    if (state->cancel || !state->root) {
+      emit loadFinished(false);
+      return;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const bool replaced = installTree(std::exchange(state->root, nullptr),
+                                      state->arena, state->lazy);
+    if (replaced && state->searchIndex && mSearchIndexEnabled) {
+      mSearchIndex = std::move(state->index);
+      mSearchIndexStale = false;
+    }
+    mKeyBytesSaved = state->keyBytesSaved;
+    if (state->measure && mStatisticsEnabled) {
+      mStatistics.readNs = state->statistics.readNs;
+      mStatistics.parseNs = state->statistics.parseNs;
+      mStatistics.buildNs = state->statistics.buildNs;
+      mStatistics.loadedBytes = state->statistics.loadedBytes;
+      mStatistics.installNs = timer.nsecsElapsed();
+      reportStatistics();
+    }
+    emit loadFinished(true);
+  });
+  thread->start();
+  return true;
+}
+
+void QJsonModel::cancelLoad() {
+  if (mAsyncLoad)
+    mAsyncLoad->cancel = true;
+}
+
+bool QJsonModel::isLoading() const { return mAsyncLoad != nullptr; }
+
+void QJsonModel::setNdjsonDevice(QIODevice *device) {
+  if (mNdjsonDevice)
+    disconnect(mNdjsonDevice, nullptr, this, nullptr);
+  mNdjsonDevice = device;
+  if (!device)
+    return;
+
+  startNdjson();
+  connect(device, &QIODevice::readyRead, this, &QJsonModel::readNdjson);
+  connect(device, &QIODevice::readChannelFinished, this, [this] {
+    readNdjson();
+    // The last record may lack its newline
+    if (!mNdjsonBuffer.isEmpty())
+      appendNdjson("\n");
+  });
+  readNdjson();
+}
+
+void QJsonModel::readNdjson() {
+  if (mNdjsonDevice && mNdjsonDevice->isReadable())
+    appendNdjson(mNdjsonDevice->readAll());
+}
+
+void QJsonModel::appendNdjson(const QByteArray &data) {
+  if (!mRootItem || mRootItem->type() != QJsonValue::Array)
+    startNdjson();
+  // Appending to a loaded array continues its numbering, from the key of
+  // its last record when older ones were trimmed away
+  const int rows = mRootItem->childCount();
+  qint64 records = rows;
+  if (rows > 0) {
+    bool ok = false;
+    const qint64 last = mRootItem->child(rows - 1)->key().toLongLong(&ok);
+    if (ok)
+      records = qMax(records, last + 1);
+  }
+  mNdjsonRecords = qMax(mNdjsonRecords, records);
+
+  mNdjsonBuffer += data;
+  const qsizetype end = mNdjsonBuffer.lastIndexOf('\n');
+  if (end < 0)
+    return;
+
+  // Records are heap nodes: the ring buffer frees them one by one. They
+  // share keys with the records that came before them.
+  QJsonTreeItem::LoadContext context{mFilter};
+  context.keepKeyOrder = mPreserveKeyOrder;
+  context.path = mFilter.rootState();
+  std::swap(context.keys, mKeys);
+  const char *text = mNdjsonBuffer.constData();
+  for (qsizetype begin = 0; begin <= end;) {
+    const qsizetype newline = mNdjsonBuffer.indexOf('\n', begin);
+    const qsizetype length = newline - begin;
+    const bool blank =
+        std::all_of(text + begin, text + newline, QJsonSax::isWhitespace);
+    if (!blank) {
+      const qint64 index = mNdjsonRecords + mNdjsonPending.size();
+      QJsonTreeItem *record = QJsonTreeBuilder::parseRecord(
+          text + begin, length, context, mRootItem, index, mParseError);
+      if (record) {
+        record->setKey(QString::number(index));
+        mNdjsonPending.append(record);
+      } else if (mParseError.error != QJsonParseError::NoError) {
+        qDebug() << Q_FUNC_INFO << "skipping invalid record:"
+                 << mParseError.errorString() << "at offset"
+                 << mParseError.offset;
+      }
+    }
+    begin = newline + 1;
+  }
+  mNdjsonBuffer.remove(0, end + 1);
+  std::swap(context.keys, mKeys);
+
+  if (!mNdjsonPending.isEmpty() && !mNdjsonFlushQueued) {
+    mNdjsonFlushQueued = true;
+    QTimer::singleShot(mNdjsonFlushInterval, this, &QJsonModel::flushNdjson);
+  }
+}
+
+void QJsonModel::flushNdjson() {
+  mNdjsonFlushQueued = false;
+  if (mNdjsonPending.isEmpty())
+    return;
+
+  QList<QJsonTreeItem *> records = std::exchange(mNdjsonPending, {});
+  mNdjsonRecords += records.size();
+  if (mMaxRows > 0 && records.size() > mMaxRows) {
+    // Records that would be dropped right away never reach the view
+    const qsizetype dropped = records.size() - mMaxRows;
+    qDeleteAll(records.begin(), records.begin() + dropped);
+    records.remove(0, dropped);
+  }
+  if (mMaxRows > 0)
+    trimRows(mMaxRows - int(records.size()));
+
+  const int first = mRootItem->childCount();
+  beginInsertRows(QModelIndex(), first, first + int(records.size()) - 1);
+  for (QJsonTreeItem *record : std::as_const(records))
+    mRootItem->appendChild(record);
+  endInsertRows();
+}
+
+void QJsonModel::setNdjsonFlushInterval(int msec) {
+  mNdjsonFlushInterval = qMax(0, msec);
+}
+
+int QJsonModel::ndjsonFlushInterval() const { return mNdjsonFlushInterval; }
+
+void QJsonModel::setMaxRows(int rows) {
+  mMaxRows = qMax(0, rows);
+  if (mMaxRows > 0)
+    trimRows(mMaxRows);
+}
+
+int QJsonModel::maxRows() const { return mMaxRows; }
+
+void QJsonModel::startNdjson() {
+  beginResetModel();
+  releaseTree();
+  mLazyTree = false;
+  mRootItem = new QJsonTreeItem;
+  mRootItem->setKey("root");
+  mRootItem->setType(QJsonValue::Array);
+  endResetModel();
+  mNdjsonBuffer.clear();
+  mNdjsonRecords = 0;
+}
+
+void QJsonModel::trimRows(int keep) {
+  const int excess = mRootItem->childCount() - qMax(0, keep);
+  if (excess <= 0)
+    return;
+
+  flushBatch();
+  // Recorded edits may point at the rows going away
+  clearUndoHistory();
+  beginRemoveRows(QModelIndex(), 0, excess - 1);
+  mRootItem->removeChildren(0, excess);
+  endRemoveRows();
+}
+
+void QJsonModel::setIncrementalReload(bool enabled) {
+  mIncrementalReload = enabled;
+}
+
+bool QJsonModel::incrementalReload() const { return mIncrementalReload; }
+
+qint64 QJsonModel::keyBytesSaved() const {
+  return mKeyBytesSaved + mKeys.bytesSaved();
+}
+
+QModelIndex QJsonModel::indexForPath(const QString &path) {
+  if (!path.startsWith('/') || !mRootItem)
+    return {};
+
+  QJsonTreeItem *item = mRootItem;
+  QModelIndex index;
+  for (const QString &segment : path.mid(1).split('/')) {
+    // "~1" first, so that "~01" decodes to "~1" as RFC 6901 requires
+    const QString key = QString(segment).replace("~1", "/").replace("~0", "~");
+    QJsonTreeItem *child = nullptr;
+
+    if (QJsonValue::Array == item->type()) {
+      bool ok = false;
+      const int row = key.toInt(&ok);
+      if (!ok || row < 0 || (key.size() > 1 && key.startsWith('0')) ||
+          !key.at(0).isDigit())
+        return {};
+      while (row >= item->childCount() && canFetchMore(index))
+        fetchMore(index);
+      child = item->child(row);
+    } else if (QJsonValue::Object == item->type()) {
+      child = item->childByKey(key);
+      while (!child && canFetchMore(index)) {
+        fetchMore(index);
+        child = item->childByKey(key);
+      }
+    }
+
+    if (!child)
+      return {};
+    item = child;
+    index = createIndex(item->row(), 0, item);
+  }
+  return index;
+}
+
+QString QJsonModel::pathForIndex(const QModelIndex &index) const {
+  if (!index.isValid())
+    return {};
+
+  QStringList segments;
+  auto *item = static_cast<QJsonTreeItem *>(index.internalPointer());
+  for (; item && item != mRootItem; item = item->parent()) {
+    // Array elements are addressed by position, whatever their key says
+    QString segment = QJsonValue::Array == item->parent()->type()
+                          ? QString::number(item->row())
+                          : item->key();
+    segments.prepend(segment.replace('~', "~0").replace('/', "~1"));
+  }
+  return '/' + segments.join('/');
+}
+
+bool QJsonModel::canMerge() const {
+  // Lazy trees are not diffed: their pending children are not nodes yet
+  return mIncrementalReload && !mLazyLoading && !mLazyTree && mRootItem &&
+         mRootItem->childCount() > 0;
+}
+
+int QJsonModel::find(const QString &pattern, Qt::MatchFlags flags) {
+  cancelFind();
+  if (!mSearchPool)
+    mSearchPool = new QThreadPool(this);
+
+  auto search = std::make_shared<Search>(++mSearchId, pattern, flags);
+  mSearch = search;
+
+  // Results cross back to the model thread, which owns the indexes
+  auto post = [this, search](const QList<QJsonTreeItem *> &items) {
+    QMetaObject::invokeMethod(
+        this, [this, search, items] { deliverResults(search, items); },
+        Qt::QueuedConnection);
+  };
+  auto done = [this, search] {
+    if (--search->pending == 0)
+      QMetaObject::invokeMethod(
+          this, [this, search] { finishSearch(search); },
+          Qt::QueuedConnection);
+  };
+
+  if (mSearchIndexEnabled && search->indexable()) {
+    const bool rebuild = mSearchIndexStale;
+    search->pending = 1;
+    mSearchPool->start([this, search, rebuild, post, done] {
+      if (rebuild) {
+        mSearchIndex.clear();
+        indexTree(mRootItem, mSearchIndex);
+        mSearchIndexStale = false;
+      }
+      QList<QJsonTreeItem *> candidates;
+      mSearchIndex.candidates(search->pattern, candidates);
+      // Candidates only share a trigram with the pattern: check each one
+      QList<QJsonTreeItem *> batch;
+      for (QJsonTreeItem *item : std::as_const(candidates)) {
+        if (search->cancel)
+          break;
+        if (!search->matches(item))
+          continue;
+        batch.append(item);
+        if (batch.size() == Search::BatchSize)
+          post(std::exchange(batch, {}));
+      }
+      if (!batch.isEmpty() && !search->cancel)
+        post(batch);
+      done();
+    });
+    return search->id;
+  }
+
+  // Without an index, split the top levels until there are enough subtrees
+  // to keep every thread busy. Split items are checked on their own.
+  const int target = 4 * mSearchPool->maxThreadCount();
+  QList<QJsonTreeItem *> queue;
+  QList<QJsonTreeItem *> split;
+  for (int i = 0; i < mRootItem->childCount(); ++i)
+    queue.append(mRootItem->child(i));
+  qsizetype head = 0;
+  while (head < queue.size() && queue.size() < target) {
+    QJsonTreeItem *item = queue.at(head);
+    if (!item->childCount()) {
+      ++head;
+      continue;
+    }
+    split.append(item);
+    queue.removeAt(head);
+    for (int i = 0; i < item->childCount(); ++i)
+      queue.append(item->child(i));
+  }
+
+  const qsizetype tasks = qMin<qsizetype>(queue.size(), target);
+  search->pending = int(tasks) + 1;
+  mSearchPool->start([search, split, post, done] {
+    search->scan(split, false, post);
+    done();
+  });
+  for (qsizetype t = 0; t < tasks; ++t) {
+    const QList<QJsonTreeItem *> subtrees = queue.mid(
+        queue.size() * t / tasks,
+        queue.size() * (t + 1) / tasks - queue.size() * t / tasks);
+    mSearchPool->start([search, subtrees, post, done] {
+      search->scan(subtrees, true, post);
+      done();
+    });
+  }
+  return search->id;
+}
 
-  return 0;
+void QJsonModel::cancelFind() {
+  if (mSearch) {
+    mSearch->cancel = true;
+    mSearch.reset();
+  }
+  if (mSearchPool)
+    mSearchPool->waitForDone();
 }
 
-void QJsonTreeItem::setKey(const QString &key) { mKey = key; }
+bool QJsonModel::isFinding() const { return mSearch != nullptr; }
 
-void QJsonTreeItem::setValue(const QVariant &value) { mValue = value; }
+void QJsonModel::setSearchIndexEnabled(bool enabled) {
+  cancelFind();
+  mSearchIndexEnabled = enabled;
+  mSearchIndex.clear();
+  mSearchIndexStale = enabled;
+}
 
-void QJsonTreeItem::setType(const QJsonValue::Type &type) { mType = type; }
+bool QJsonModel::searchIndexEnabled() const { return mSearchIndexEnabled; }
 
-QString QJsonTreeItem::key() const { return mKey; }
+void QJsonModel::setStatisticsEnabled(bool enabled) {
+  mStatisticsEnabled = enabled;
+}
 
-QVariant QJsonTreeItem::value() const { return mValue; }
+bool QJsonModel::statisticsEnabled() const { return mStatisticsEnabled; }
 
-QJsonValue::Type QJsonTreeItem::type() const { return mType; }
+QJsonModelStatistics QJsonModel::statistics() const { return mStatistics; }
 
-QJsonTreeItem *QJsonTreeItem::load(const QJsonValue &value,
-                                   const QStringList &exceptions,
-                                   QJsonTreeItem *parent) {
-  QJsonTreeItem *rootItem = new QJsonTreeItem(parent);
-  rootItem->setKey("root");
-
-  if (value.isObject()) {
-    // Get all QJsonValue childs
-    const QStringList keys =
-        value.toObject().keys(); // To prevent clazy-range warning
-    for (const QString &key : keys) {
-      if (contains(exceptions, key)) {
-        continue;
-      }
-      QJsonValue v = value.toObject().value(key);
-      QJsonTreeItem *child = load(v, exceptions, rootItem);
-      child->setKey(key);
-      child->setType(v.type());
-      rootItem->appendChild(child);
-    }
-  } else if (value.isArray()) {
-    // Get all QJsonValue childs
-    int index = 0;
-    const QJsonArray array = value.toArray(); // To prevent clazy-range warning
-    for (const QJsonValue &v : array) {
-      QJsonTreeItem *child = load(v, exceptions, rootItem);
-      child->setKey(QString::number(index));
-      child->setType(v.type());
-      rootItem->appendChild(child);
-      ++index;
-    }
-  } else {
-    rootItem->setValue(value.toVariant());
-    rootItem->setType(value.type());
-  }
+void QJsonModel::resetStatistics() { mStatistics = {}; }
 
-  return rootItem;
+//! Refreshes the tree figures, which cost a walk over the tree, and
+//! publishes the statistics.
+void QJsonModel::reportStatistics() {
+  if (mRootItem)
+    measureTree(mRootItem, mStatistics);
+  emit statisticsUpdated(mStatistics);
 }
 
-//=========================================================================
-
-inline uchar hexdig(uint u) { return (u < 0xa ? '0' + u : 'a' + u - 0xa); }
-
-QByteArray escapedString(const QString &s) {
-  QByteArray ba(s.length(), Qt::Uninitialized);
-  uchar *cursor = reinterpret_cast<uchar *>(const_cast<char *>(ba.constData()));
-  const uchar *ba_end = cursor + ba.length();
-  const ushort *src = reinterpret_cast<const ushort *>(s.constBegin());
-  const ushort *const end = reinterpret_cast<const ushort *>(s.constEnd());
-  while (src != end) {
-    if (cursor >= ba_end - 6) {
-      // ensure we have enough space
-      int pos = cursor - reinterpret_cast<const uchar *>(ba.constData());
-      ba.resize(ba.size() * 2);
-      cursor = reinterpret_cast<uchar *>(ba.data()) + pos;
-      ba_end = reinterpret_cast<const uchar *>(ba.constData()) + ba.length();
-    }
-    uint u = *src++;
-    if (u < 0x80) {
-      if (u < 0x20 || u == 0x22 || u == 0x5c) {
-        *cursor++ = '\\';
-        switch (u) {
-        case 0x22:
-          *cursor++ = '"';
-          break;
-        case 0x5c:
-          *cursor++ = '\\';
-          break;
-        case 0x8:
-          *cursor++ = 'b';
-          break;
-        case 0xc:
-          *cursor++ = 'f';
-          break;
-        case 0xa:
-          *cursor++ = 'n';
-          break;
-        case 0xd:
-          *cursor++ = 'r';
-          break;
-        case 0x9:
-          *cursor++ = 't';
-          break;
-        default:
-          *cursor++ = 'u';
-          *cursor++ = '0';
-          *cursor++ = '0';
-          *cursor++ = hexdig(u >> 4);
-          *cursor++ = hexdig(u & 0xf);
-        }
-      } else {
-        *cursor++ = (uchar)u;
-      }
-    } else if (QUtf8Functions::toUtf8<QUtf8BaseTraits>(u, cursor, src, end) <
-               0) {
-      // failed to get valid utf8 use JSON escape sequence
-      *cursor++ = '\\';
-      *cursor++ = 'u';
-      *cursor++ = hexdig(u >> 12 & 0x0f);
-      *cursor++ = hexdig(u >> 8 & 0x0f);
-      *cursor++ = hexdig(u >> 4 & 0x0f);
-      *cursor++ = hexdig(u & 0x0f);
-    }
-  }
-  ba.resize(cursor - reinterpret_cast<const uchar *>(ba.constData()));
-  return ba;
+void QJsonModel::invalidateSearch() {
+  cancelFind();
+  if (!mSearchIndexEnabled)
+    return;
+  mSearchIndex.clear();
+  mSearchIndexStale = true;
 }
 
-QJsonModel::QJsonModel(QObject *parent)
-    : QAbstractItemModel(parent), mRootItem{new QJsonTreeItem} {
-  mHeaders.append("key");
-  mHeaders.append("value");
+void QJsonModel::rebuildSearchIndex() {
+  cancelFind();
+  mSearchIndex.clear();
+  indexTree(mRootItem, mSearchIndex);
+  mSearchIndexStale = false;
 }
 
-QJsonModel::QJsonModel(const QString &fileName, QObject *parent)
-    : QAbstractItemModel(parent), mRootItem{new QJsonTreeItem} {
-  mHeaders.append("key");
-  mHeaders.append("value");
-  load(fileName);
-}
+void QJsonModel::deliverResults(const std::shared_ptr<Search> &search,
+                                const QList<QJsonTreeItem *> &items) {
+  // Results of a cancelled search may point at items that are gone
+  if (search != mSearch)
+    return;
 
-QJsonModel::QJsonModel(QIODevice *device, QObject *parent)
-    : QAbstractItemModel(parent), mRootItem{new QJsonTreeItem} {
-  mHeaders.append("key");
-  mHeaders.append("value");
-  load(device);
+  QModelIndexList indexes;
+  indexes.reserve(items.size());
+  for (QJsonTreeItem *item : items)
+    indexes.append(createIndex(item->row(), 0, item));
+  search->found += items.size();
+  emit searchResults(search->id, indexes);
 }
 
-QJsonModel::QJsonModel(const QByteArray &json, QObject *parent)
-    : QAbstractItemModel(parent), mRootItem{new QJsonTreeItem} {
-  mHeaders.append("key");
-  mHeaders.append("value");
-  loadJson(json);
+void QJsonModel::finishSearch(const std::shared_ptr<Search> &search) {
+  if (search != mSearch)
+    return;
+  mSearch.reset();
+  emit searchFinished(search->id, search->found);
 }
 
-QJsonModel::~QJsonModel() { delete mRootItem; }
+//! Makes \a root the model tree. Returns false if it was merged into the
+//! current tree (see setIncrementalReload()) rather than replacing it.
+bool QJsonModel::installTree(QJsonTreeItem *root, QJsonTreeArena &arena,
+                             bool lazy) {
+  // Merging changes values before any signal says so
+  invalidateSearch();
+  flushBatch();
+  clearUndoHistory();
+  if (arena.count() == 0 && !lazy && canMerge()) {
+    mergeItem(mRootItem, root, QModelIndex());
+    delete root;
+    return false;
+  }
 
-bool QJsonModel::load(const QString &fileName) {
-  QFile file(fileName);
-  bool success = false;
-  if (file.open(QIODevice::ReadOnly)) {
-    success = load(&file);
-    file.close();
-  } else {
-    success = false;
+  beginResetModel();
+  releaseTree();
+  mArena.merge(arena);
+  mRootItem = root;
+  mLazyTree = lazy;
+  endResetModel();
+  return true;
+}
+
+//! Updates \a item, at \a index, to match \a fresh. Children of \a fresh
+//! are either moved into \a item or deleted; \a fresh is left childless.
+void QJsonModel::mergeItem(QJsonTreeItem *item, QJsonTreeItem *fresh,
+                           const QModelIndex &index) {
+  const QJsonValue::Type type = fresh->type();
+  const bool container =
+      QJsonValue::Array == type || QJsonValue::Object == type;
+
+  if (item->type() != type || item->scalar() != fresh->scalar()) {
+    // Children of a different kind of container have nothing to match
+    if (item->type() != type && item->childCount() > 0) {
+      beginRemoveRows(index, 0, item->childCount() - 1);
+      item->removeChildren(0, item->childCount());
+      endRemoveRows();
+    }
+    item->setType(type);
+    item->setScalar(fresh->scalar());
+    if (index.isValid()) {
+      const QModelIndex value = index.siblingAtColumn(1);
+      emit dataChanged(value, value);
+    }
   }
 
-  return success;
+  if (container)
+    mergeChildren(item, fresh, index);
 }
 
-bool QJsonModel::load(QIODevice *device) { return loadJson(device->readAll()); }
+void QJsonModel::mergeChildren(QJsonTreeItem *item, QJsonTreeItem *fresh,
+                               const QModelIndex &parent) {
+  const QList<QJsonTreeItem *> incoming = fresh->takeChildren();
+  const int count = int(incoming.size());
 
-bool QJsonModel::loadJson(const QByteArray &json) {
-  auto const &jdoc = QJsonDocument::fromJson(json);
+  if (QJsonValue::Array == fresh->type()) {
+    const int common = qMin(item->childCount(), count);
+    for (int i = 0; i < common; ++i) {
+      mergeItem(item->child(i), incoming.at(i), index(i, 0, parent));
+      delete incoming.at(i);
+    }
+    if (item->childCount() > common) {
+      beginRemoveRows(parent, common, item->childCount() - 1);
+      item->removeChildren(common, item->childCount() - common);
+      endRemoveRows();
+    } else if (count > common) {
+      beginInsertRows(parent, common, count - 1);
+      item->insertChildren(common, incoming.mid(common));
+      endInsertRows();
+    }
+    return;
+  }
 
-  if (!jdoc.isNull()) {
-    beginResetModel();
-    delete mRootItem;
-    if (jdoc.isArray()) {
-      mRootItem = QJsonTreeItem::load(QJsonValue(jdoc.array()), mExceptions);
-      mRootItem->setType(QJsonValue::Array);
+  // Objects: drop the keys that are gone, one removal per run of rows
+  QSet<QString> incomingKeys;
+  incomingKeys.reserve(count);
+  for (QJsonTreeItem *child : incoming)
+    incomingKeys.insert(child->key());
+  for (int row = item->childCount(); row > 0;) {
+    if (incomingKeys.contains(item->child(row - 1)->key())) {
+      --row;
+      continue;
+    }
+    int first = row - 1;
+    while (first > 0 && !incomingKeys.contains(item->child(first - 1)->key()))
+      --first;
+    beginRemoveRows(parent, first, row - 1);
+    item->removeChildren(first, row - first);
+    endRemoveRows();
+    row = first;
+  }
 
-    } else {
-      mRootItem = QJsonTreeItem::load(QJsonValue(jdoc.object()), mExceptions);
-      mRootItem->setType(QJsonValue::Object);
+  // Then walk the new keys in order: rows before i already match
+  QSet<QString> currentKeys;
+  currentKeys.reserve(item->childCount());
+  for (int row = 0; row < item->childCount(); ++row)
+    currentKeys.insert(item->child(row)->key());
+  for (int i = 0; i < count;) {
+    QJsonTreeItem *next = incoming.at(i);
+    if (!currentKeys.contains(next->key())) {
+      int end = i + 1;
+      while (end < count && !currentKeys.contains(incoming.at(end)->key()))
+        ++end;
+      beginInsertRows(parent, i, end - 1);
+      item->insertChildren(i, incoming.mid(i, end - i));
+      endInsertRows();
+      i = end;
+      continue;
     }
-    endResetModel();
-    return true;
+
+    if (item->child(i)->key() != next->key()) {
+      // Only happens with preserveKeyOrder(): the key moved up
+      int from = i + 1;
+      while (item->child(from)->key() != next->key())
+        ++from;
+      beginMoveRows(parent, from, from, parent, i);
+      item->insertChild(i, item->takeChild(from));
+      endMoveRows();
+    }
+    mergeItem(item->child(i), next, index(i, 0, parent));
+    delete next;
+    ++i;
   }
+}
 
-  qDebug() << Q_FUNC_INFO << "cannot load json";
-  return false;
+void QJsonModel::releaseTree() {
+  // A reset reports every edit
+  mBatchItems.clear();
+  clearUndoHistory();
+  // Queued records hold a pointer to the root they were parsed for
+  qDeleteAll(mNdjsonPending);
+  mNdjsonPending.clear();
+  if (mRootItem && !mRootItem->isArenaOwned())
+    delete mRootItem;
+  mRootItem = nullptr;
+  QJsonTreeItem::destroyArena(mArena);
+  mKeys.clear();
+  mKeyBytesSaved = 0;
 }
 
 QVariant QJsonModel::data(const QModelIndex &index, int role) const {
+  if (mStatisticsEnabled)
+    ++mStatistics.dataCalls;
   if (!index.isValid())
     return {};
 
@@ -270,8 +2776,27 @@ bool QJsonModel::setData(const QModelIndex &index, const QVariant &value,
     if (col == 1) {
       QJsonTreeItem *item =
           static_cast<QJsonTreeItem *>(index.internalPointer());
-      item->setValue(value);
-      emit dataChanged(index, index, {Qt::EditRole});
+      cancelFind();
+      const QJsonScalar before = item->scalar();
+      const QJsonValue::Type typeBefore = item->type();
+      if (!item->setValue(value))
+        return false;
+      if (mUndo && !mUndo->replaying) {
+        UndoHistory::Edit edit;
+        edit.items = {item};
+        edit.before = before;
+        edit.after = item->scalar();
+        edit.typeBefore = typeBefore;
+        edit.typeAfter = item->type();
+        mUndo->record(std::move(edit));
+        reportUndoState();
+      }
+      if (mSearchIndexEnabled && !mSearchIndexStale)
+        mSearchIndex.add(item, item->scalar().toString());
+      if (mBatchDepth > 0)
+        mBatchItems.append(item);
+      else
+        emit dataChanged(index, index, {Qt::EditRole});
       return true;
     }
   }
@@ -279,6 +2804,57 @@ bool QJsonModel::setData(const QModelIndex &index, const QVariant &value,
   return false;
 }
 
+void QJsonModel::beginBatch() { ++mBatchDepth; }
+
+void QJsonModel::commitBatch() {
+  if (mBatchDepth == 0) {
+    qDebug() << Q_FUNC_INFO << "no batch to commit";
+    return;
+  }
+  if (--mBatchDepth == 0)
+    flushBatch();
+}
+
+bool QJsonModel::setDataBatch(const QList<QPair<QModelIndex, QVariant>> &edits,
+                              int role) {
+  bool success = true;
+  beginBatch();
+  for (const auto &edit : edits) {
+    if (!setData(edit.first, edit.second, role))
+      success = false;
+  }
+  commitBatch();
+  return success;
+}
+
+//! Emits the pending batch edits as runs of consecutive rows, one
+//! dataChanged() per run, and forgets them.
+void QJsonModel::flushBatch() {
+  if (mBatchItems.isEmpty())
+    return;
+
+  QHash<QJsonTreeItem *, QList<int>> rows;
+  for (QJsonTreeItem *item : std::as_const(mBatchItems))
+    rows[item->parent()].append(item->row());
+  mBatchItems.clear();
+
+  for (auto it = rows.begin(); it != rows.end(); ++it) {
+    QJsonTreeItem *parent = it.key();
+    QList<int> &list = it.value();
+    std::sort(list.begin(), list.end());
+    for (qsizetype first = 0, last = 0; first < list.size(); first = ++last) {
+      // Repeated rows are part of the run too
+      while (last + 1 < list.size() && list.at(last + 1) <= list.at(last) + 1)
+        ++last;
+      const int top = list.at(first);
+      const int bottom = list.at(last);
+      emit dataChanged(createIndex(top, 1, parent->child(top)),
+                       createIndex(bottom, 1, parent->child(bottom)),
+                       {Qt::EditRole});
+    }
+  }
+}
+
 QVariant QJsonModel::headerData(int section, Qt::Orientation orientation,
                                 int role) const {
   if (role != Qt::DisplayRole)
@@ -292,6 +2868,8 @@ QVariant QJsonModel::headerData(int section, Qt::Orientation orientation,
 
 QModelIndex QJsonModel::index(int row, int column,
                               const QModelIndex &parent) const {
+  if (mStatisticsEnabled)
+    ++mStatistics.indexCalls;
   if (!hasIndex(row, column, parent))
     return {};
 
@@ -310,6 +2888,8 @@ QModelIndex QJsonModel::index(int row, int column,
 }
 
 QModelIndex QJsonModel::parent(const QModelIndex &index) const {
+  if (mStatisticsEnabled)
+    ++mStatistics.parentCalls;
   if (!index.isValid())
     return {};
 
@@ -341,6 +2921,378 @@ int QJsonModel::columnCount(const QModelIndex &parent) const {
   return 2;
 }
 
+bool QJsonModel::hasChildren(const QModelIndex &parent) const {
+  if (parent.column() > 0)
+    return false;
+
+  QJsonTreeItem *parentItem;
+  if (!parent.isValid())
+    parentItem = mRootItem;
+  else
+    parentItem = static_cast<QJsonTreeItem *>(parent.internalPointer());
+
+  return parentItem->childCount() > 0 || parentItem->canFetchMore();
+}
+
+bool QJsonModel::canFetchMore(const QModelIndex &parent) const {
+  if (parent.column() > 0)
+    return false;
+
+  QJsonTreeItem *parentItem;
+  if (!parent.isValid())
+    parentItem = mRootItem;
+  else
+    parentItem = static_cast<QJsonTreeItem *>(parent.internalPointer());
+
+  return parentItem->canFetchMore();
+}
+
+void QJsonModel::fetchMore(const QModelIndex &parent) {
+  if (parent.column() > 0)
+    return;
+
+  QJsonTreeItem *parentItem;
+  if (!parent.isValid())
+    parentItem = mRootItem;
+  else
+    parentItem = static_cast<QJsonTreeItem *>(parent.internalPointer());
+
+  const QList<QJsonTreeItem *> items =
+      parentItem->fetchMore(mFetchBatchSize, mFilter, &mKeys);
+  if (items.isEmpty())
+    return;
+
+  const int first = parentItem->childCount();
+  beginInsertRows(parent, first, first + int(items.size()) - 1);
+  for (QJsonTreeItem *item : items)
+    parentItem->appendChild(item);
+  endInsertRows();
+}
+
+//! Returns the array or object at \a parent, null for anything else. Its
+//! pending lazy children are fetched, so that rows match the document.
+QJsonTreeItem *QJsonModel::containerItem(const QModelIndex &parent) {
+  if (!mRootItem || parent.column() > 0)
+    return nullptr;
+
+  QJsonTreeItem *item =
+      parent.isValid() ? static_cast<QJsonTreeItem *>(parent.internalPointer())
+                       : mRootItem;
+  if (QJsonValue::Array != item->type() && QJsonValue::Object != item->type())
+    return nullptr;
+
+  while (item->canFetchMore())
+    fetchMore(parent);
+  return item;
+}
+
+//! First of "key1", "key2"... neither a member of \a object nor in \a taken.
+static QString freeKey(QJsonTreeItem *object, const QSet<QString> &taken) {
+  for (int n = 1;; ++n) {
+    const QString key = QStringLiteral("key%1").arg(n);
+    if (!taken.contains(key) && !object->childByKey(key))
+      return key;
+  }
+}
+
+bool QJsonModel::insertRows(int row, int count, const QModelIndex &parent) {
+  QJsonTreeItem *parentItem = containerItem(parent);
+  if (!parentItem || count <= 0 || row < 0 || row > parentItem->childCount())
+    return false;
+
+  const bool isObject = QJsonValue::Object == parentItem->type();
+  QSet<QString> taken;
+  QList<QJsonTreeItem *> items;
+  items.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    QJsonTreeItem *item = new QJsonTreeItem(parentItem);
+    item->setScalar(nullptr);
+    if (isObject) {
+      const QString key = freeKey(parentItem, taken);
+      taken.insert(key);
+      item->setKey(key);
+    }
+    items.append(item);
+  }
+
+  insertItems(parentItem, row, items);
+  if (mUndo && !mUndo->replaying) {
+    UndoHistory::Edit edit;
+    edit.kind = UndoHistory::Edit::Insert;
+    edit.from = parentItem;
+    edit.row = row;
+    edit.items = items;
+    mUndo->record(std::move(edit));
+    reportUndoState();
+  }
+  return true;
+}
+
+bool QJsonModel::removeRows(int row, int count, const QModelIndex &parent) {
+  QJsonTreeItem *parentItem = containerItem(parent);
+  if (!parentItem || count <= 0 || row < 0 ||
+      row + count > parentItem->childCount())
+    return false;
+
+  if (mUndo && !mUndo->replaying) {
+    // The history keeps the rows for undo()
+    UndoHistory::Edit edit;
+    edit.kind = UndoHistory::Edit::Remove;
+    edit.from = parentItem;
+    edit.row = row;
+    edit.items = takeItems(parentItem, row, count);
+    mUndo->record(std::move(edit));
+    reportUndoState();
+    return true;
+  }
+
+  // Edited items may be among the removed ones
+  flushBatch();
+  beginRemoveRows(parent, row, row + count - 1);
+  parentItem->removeChildren(row, count);
+  endRemoveRows();
+  return true;
+}
+
+bool QJsonModel::moveRows(const QModelIndex &sourceParent, int sourceRow,
+                          int count, const QModelIndex &destinationParent,
+                          int destinationChild) {
+  QJsonTreeItem *from = containerItem(sourceParent);
+  QJsonTreeItem *to = containerItem(destinationParent);
+  if (!from || !to || count <= 0 || sourceRow < 0 ||
+      sourceRow + count > from->childCount() || destinationChild < 0 ||
+      destinationChild > to->childCount())
+    return false;
+  // Rows moved to where they already are
+  if (from == to && destinationChild >= sourceRow &&
+      destinationChild <= sourceRow + count)
+    return false;
+
+  // Keys of the moved rows where they are, and where they go
+  const bool fromObject = QJsonValue::Object == from->type();
+  const bool toObject = QJsonValue::Object == to->type();
+  QStringList fromKeys;
+  QStringList toKeys;
+  for (int i = sourceRow; i < sourceRow + count; ++i) {
+    const QString key = from->child(i)->key();
+    if (fromObject)
+      fromKeys.append(key);
+    if (toObject) {
+      if (from != to && to->childByKey(key))
+        return false;
+      toKeys.append(key);
+    }
+  }
+
+  // Rows after the moved ones shift up once these are taken
+  const int target =
+      from == to && destinationChild > sourceRow ? destinationChild - count
+                                                 : destinationChild;
+  QList<QJsonTreeItem *> items;
+  for (int i = sourceRow; i < sourceRow + count; ++i)
+    items.append(from->child(i));
+  if (!moveItems(from, sourceRow, count, to, target, toKeys))
+    return false;
+
+  if (mUndo && !mUndo->replaying) {
+    UndoHistory::Edit edit;
+    edit.kind = UndoHistory::Edit::Move;
+    edit.from = from;
+    edit.to = to;
+    edit.row = sourceRow;
+    edit.target = target;
+    edit.items = items;
+    edit.fromKeys = fromKeys;
+    edit.toKeys = toKeys;
+    mUndo->record(std::move(edit));
+    reportUndoState();
+  }
+  return true;
+}
+
+QModelIndex QJsonModel::insertValue(const QModelIndex &parent, int row,
+                                    const QJsonValue &value,
+                                    const QString &key) {
+  QJsonTreeItem *parentItem = containerItem(parent);
+  if (!parentItem)
+    return {};
+  if (row < 0 || row > parentItem->childCount())
+    row = parentItem->childCount();
+
+  QString name;
+  if (QJsonValue::Object == parentItem->type()) {
+    if (!key.isEmpty() && parentItem->childByKey(key))
+      return {};
+    name = key.isEmpty() ? freeKey(parentItem, {}) : key;
+  }
+
+  QJsonTreeItem *item = QJsonTreeItem::load(value, {}, parentItem);
+  item->setKey(name);
+  insertItems(parentItem, row, {item});
+  if (mUndo && !mUndo->replaying) {
+    UndoHistory::Edit edit;
+    edit.kind = UndoHistory::Edit::Insert;
+    edit.from = parentItem;
+    edit.row = row;
+    edit.items = {item};
+    mUndo->record(std::move(edit));
+    reportUndoState();
+  }
+  return createIndex(row, 0, item);
+}
+
+QModelIndex QJsonModel::indexOf(QJsonTreeItem *item) const {
+  if (item == mRootItem)
+    return {};
+  return createIndex(item->row(), 0, item);
+}
+
+void QJsonModel::insertItems(QJsonTreeItem *parent, int row,
+                             const QList<QJsonTreeItem *> &items) {
+  beginInsertRows(indexOf(parent), row, row + int(items.size()) - 1);
+  parent->insertChildren(row, items);
+  endInsertRows();
+}
+
+//! Detaches rows of \a parent, without deleting them.
+QList<QJsonTreeItem *> QJsonModel::takeItems(QJsonTreeItem *parent, int row,
+                                             int count) {
+  // Edited items may be among the taken ones
+  flushBatch();
+  beginRemoveRows(indexOf(parent), row, row + count - 1);
+  const QList<QJsonTreeItem *> items = parent->takeChildren(row, count);
+  endRemoveRows();
+  return items;
+}
+
+//! Moves rows of \a from so that they start at row \a target of \a to once
+//! moved, renamed to \a keys, or left without keys in an array.
+bool QJsonModel::moveItems(QJsonTreeItem *from, int row, int count,
+                           QJsonTreeItem *to, int target,
+                           const QStringList &keys) {
+  // Qt counts the destination before the rows are taken out
+  const int destination = from == to && target > row ? target + count : target;
+  // Also refuses moving rows into their own subtree
+  if (!beginMoveRows(indexOf(from), row, row + count - 1, indexOf(to),
+                     destination))
+    return false;
+
+  const QList<QJsonTreeItem *> items = from->takeChildren(row, count);
+  for (qsizetype i = 0; i < items.size(); ++i)
+    items.at(i)->setKey(keys.value(i));
+  to->insertChildren(target, items);
+  endMoveRows();
+  return true;
+}
+
+void QJsonModel::setUndoLimit(int limit) {
+  if (limit <= 0) {
+    clearUndoHistory();
+    mUndo.reset();
+    return;
+  }
+  if (!mUndo)
+    mUndo = std::make_unique<UndoHistory>();
+  mUndo->limit = limit;
+  while (mUndo->done.size() > limit)
+    UndoHistory::release(mUndo->done.takeFirst(), true);
+  reportUndoState();
+}
+
+int QJsonModel::undoLimit() const { return mUndo ? mUndo->limit : 0; }
+
+void QJsonModel::snapshot() {
+  if (!mUndo)
+    return;
+  mUndo->close();
+  reportUndoState();
+}
+
+bool QJsonModel::canUndo() const {
+  return mUndo && (!mUndo->open.isEmpty() || !mUndo->done.isEmpty());
+}
+
+bool QJsonModel::canRedo() const { return mUndo && !mUndo->undone.isEmpty(); }
+
+bool QJsonModel::undo() {
+  if (!canUndo())
+    return false;
+  // Edits since the last snapshot are a step of their own
+  mUndo->close();
+  return replaySteps(true);
+}
+
+bool QJsonModel::redo() {
+  if (!canRedo())
+    return false;
+  return replaySteps(false);
+}
+
+void QJsonModel::clearUndoHistory() {
+  if (!mUndo)
+    return;
+  mUndo->clear();
+  reportUndoState();
+}
+
+//! Reverts the last done step when \a undo, or else runs the last undone
+//! one again. Steps hold the rows of the state they left, so they replay
+//! in order without looking anything up.
+bool QJsonModel::replaySteps(bool undo) {
+  cancelFind();
+  using Edit = UndoHistory::Edit;
+  UndoHistory::Step step = (undo ? mUndo->done : mUndo->undone).takeLast();
+  mUndo->replaying = true;
+  beginBatch();
+  for (qsizetype i = 0; i < step.size(); ++i) {
+    const Edit &edit = step.at(undo ? step.size() - 1 - i : i);
+    const int count = int(edit.items.size());
+    switch (edit.kind) {
+    case Edit::SetValue: {
+      QJsonTreeItem *item = edit.items.first();
+      item->setScalar(undo ? edit.before : edit.after);
+      item->setType(undo ? edit.typeBefore : edit.typeAfter);
+      if (mSearchIndexEnabled && !mSearchIndexStale)
+        mSearchIndex.add(item, item->scalar().toString());
+      mBatchItems.append(item);
+      break;
+    }
+    case Edit::Insert:
+    case Edit::Remove:
+      // Undoing a removal inserts, as does redoing an insertion
+      if ((Edit::Remove == edit.kind) == undo)
+        insertItems(edit.from, edit.row, edit.items);
+      else
+        takeItems(edit.from, edit.row, count);
+      break;
+    case Edit::Move:
+      if (undo)
+        moveItems(edit.to, edit.target, count, edit.from, edit.row,
+                  edit.fromKeys);
+      else
+        moveItems(edit.from, edit.row, count, edit.to, edit.target,
+                  edit.toKeys);
+      break;
+    }
+  }
+  commitBatch();
+  mUndo->replaying = false;
+  (undo ? mUndo->undone : mUndo->done).append(std::move(step));
+  reportUndoState();
+  return true;
+}
+
+void QJsonModel::reportUndoState() {
+  if (!mUndo)
+    return;
+  const bool undo = canUndo();
+  const bool redo = canRedo();
+  if (std::exchange(mUndo->couldUndo, undo) != undo)
+    emit canUndoChanged(undo);
+  if (std::exchange(mUndo->couldRedo, redo) != redo)
+    emit canRedoChanged(redo);
+}
+
 Qt::ItemFlags QJsonModel::flags(const QModelIndex &index) const {
   int col = index.column();
   auto item = static_cast<QJsonTreeItem *>(index.internalPointer());
@@ -355,36 +3307,100 @@ Qt::ItemFlags QJsonModel::flags(const QModelIndex &index) const {
 }
 
 QByteArray QJsonModel::json(bool compact) {
-  auto jsonValue = genJson(mRootItem);
+  QElapsedTimer timer;
+  if (mStatisticsEnabled)
+    timer.start();
   QByteArray json;
-  if (jsonValue.isNull())
-    return json;
+  QJsonTreeWriter writer(json, nullptr, compact, mFilter);
+  writer.write(mRootItem);
+  if (mStatisticsEnabled) {
+    mStatistics.serializeNs = timer.nsecsElapsed();
+    mStatistics.serializedBytes = writer.bytesWritten();
+    reportStatistics();
+  }
+  return json;
+}
 
-  if (jsonValue.isArray())
-    arrayToJson(jsonValue.toArray(), json, 0, compact);
-  else
-    objectToJson(jsonValue.toObject(), json, 0, compact);
+QByteArray QJsonModel::cbor() {
+  QElapsedTimer timer;
+  if (mStatisticsEnabled)
+    timer.start();
+  QByteArray cbor;
+  if (mRootItem) {
+    QCborStreamWriter writer(&cbor);
+    writeCbor(writer, mRootItem, mFilter);
+  }
+  if (mStatisticsEnabled) {
+    mStatistics.serializeNs = timer.nsecsElapsed();
+    mStatistics.serializedBytes = cbor.size();
+    reportStatistics();
+  }
+  return cbor;
+}
 
-  return json;
+bool QJsonModel::save(const QString &fileName, bool compact) {
+  QFile file(fileName);
+  bool success = false;
+  if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    success = save(&file, compact);
+    file.close();
+  }
+
+  return success;
+}
+
+bool QJsonModel::save(QIODevice *device, bool compact) {
+  QElapsedTimer timer;
+  if (mStatisticsEnabled)
+    timer.start();
+  QByteArray buffer;
+  QJsonTreeWriter writer(buffer, device, compact, mFilter);
+  const bool success = writer.write(mRootItem);
+  if (mStatisticsEnabled) {
+    mStatistics.serializeNs = timer.nsecsElapsed();
+    mStatistics.serializedBytes = writer.bytesWritten();
+    reportStatistics();
+  }
+  return success;
+}
+
+bool QJsonModel::save(const QString &fileName, Format format) {
+  QFile file(fileName);
+  bool success = false;
+  if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    success = save(&file, format);
+    file.close();
+  }
+
+  return success;
+}
+
+bool QJsonModel::save(QIODevice *device, Format format) {
+  if (Format::Json == format)
+    return save(device);
+  // The encoding is compact enough to build in memory first
+  const QByteArray data = cbor();
+  return device->write(data) == data.size();
 }
 
-void QJsonModel::objectToJson(QJsonObject jsonObject, QByteArray &json,
-                              int indent, bool compact) {
+void QJsonModel::objectToJson(const QJsonObject &jsonObject,
+                              QByteArray &json, int indent, bool compact) {
   json += compact ? "{" : "{\n";
   objectContentToJson(jsonObject, json, indent + (compact ? 0 : 1), compact);
   json += QByteArray(4 * indent, ' ');
   json += compact ? "}" : "}\n";
 }
-void QJsonModel::arrayToJson(QJsonArray jsonArray, QByteArray &json, int indent,
-                             bool compact) {
+void QJsonModel::arrayToJson(const QJsonArray &jsonArray, QByteArray &json,
+                             int indent, bool compact) {
   json += compact ? "[" : "[\n";
   arrayContentToJson(jsonArray, json, indent + (compact ? 0 : 1), compact);
   json += QByteArray(4 * indent, ' ');
   json += compact ? "]" : "]\n";
 }
 
-void QJsonModel::arrayContentToJson(QJsonArray jsonArray, QByteArray &json,
-                                    int indent, bool compact) {
+void QJsonModel::arrayContentToJson(const QJsonArray &jsonArray,
+                                    QByteArray &json, int indent,
+                                    bool compact) {
   if (jsonArray.size() <= 0)
     return;
 
@@ -401,31 +3417,29 @@ void QJsonModel::arrayContentToJson(QJsonArray jsonArray, QByteArray &json,
     json += compact ? "," : ",\n";
   }
 }
-void QJsonModel::objectContentToJson(QJsonObject jsonObject, QByteArray &json,
-                                     int indent, bool compact) {
+void QJsonModel::objectContentToJson(const QJsonObject &jsonObject,
+                                     QByteArray &json, int indent,
+                                     bool compact) {
   if (jsonObject.size() <= 0)
     return;
 
   QByteArray indentString(4 * indent, ' ');
-  int i = 0;
-  while (1) {
-    QString key = jsonObject.keys().at(i);
+  // One pass over the members: no keys() rebuild nor value(key) lookup
+  for (auto it = jsonObject.constBegin(); it != jsonObject.constEnd(); ++it) {
+    if (it != jsonObject.constBegin())
+      json += compact ? "," : ",\n";
     json += indentString;
     json += '"';
-    json += escapedString(key);
+    appendEscaped(json, it.key());
     json += compact ? "\":" : "\": ";
-    valueToJson(jsonObject.value(key), json, indent, compact);
-    if (++i == jsonObject.size()) {
-      if (!compact)
-        json += '\n';
-      break;
-    }
-    json += compact ? "," : ",\n";
+    valueToJson(it.value(), json, indent, compact);
   }
+  if (!compact)
+    json += '\n';
 }
 
-void QJsonModel::valueToJson(QJsonValue jsonValue, QByteArray &json, int indent,
-                             bool compact) {
+void QJsonModel::valueToJson(const QJsonValue &jsonValue, QByteArray &json,
+                             int indent, bool compact) {
   QJsonValue::Type type = jsonValue.type();
   switch (type) {
   case QJsonValue::Bool:
@@ -442,7 +3456,7 @@ void QJsonModel::valueToJson(QJsonValue jsonValue, QByteArray &json, int indent,
   }
   case QJsonValue::String:
     json += '"';
-    json += escapedString(jsonValue.toString());
+    appendEscaped(json, jsonValue.toString());
     json += '"';
     break;
   case QJsonValue::Array:
@@ -466,40 +3480,5 @@ void QJsonModel::valueToJson(QJsonValue jsonValue, QByteArray &json, int indent,
 }
 
 void QJsonModel::addException(const QStringList &exceptions) {
-  mExceptions = exceptions;
-}
-
-QJsonValue QJsonModel::genJson(QJsonTreeItem *item) const {
-  auto type = item->type();
-  int nchild = item->childCount();
-
-  if (QJsonValue::Object == type) {
-    QJsonObject jo;
-    for (int i = 0; i < nchild; ++i) {
-      auto ch = item->child(i);
-      auto key = ch->key();
-      jo.insert(key, genJson(ch));
-    }
-    return jo;
-  } else if (QJsonValue::Array == type) {
-    QJsonArray arr;
-    for (int i = 0; i < nchild; ++i) {
-      auto ch = item->child(i);
-      arr.append(genJson(ch));
-    }
-    return arr;
-  } else {
-    QJsonValue va;
-    switch (item->value().typeId()) {
-    case QMetaType::Bool: {
-      va = item->value().toBool();
-      break;
-    }
-    default:
-      va = item->value().toString();
-      break;
-    }
-    (item->value());
-    return va;
-  }
+  mFilter = QJsonKeyFilter(exceptions);
 }
@@ -0,0 +1,160 @@
+/* QJsonCorpus.hpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QRandomGenerator>
+#include <QString>
+
+/// Synthetic JSON documents for the benchmarks. Every generator is seeded,
+/// so a given size always yields the same bytes, and \a nodes is the
+/// approximate number of values in the result.
+namespace QJsonCorpus {
+enum class Shape { Deep, Wide, Strings, Numbers };
+
+inline QByteArray shapeName(Shape shape) {
+  switch (shape) {
+  case Shape::Deep:
+    return "deep";
+  case Shape::Wide:
+    return "wide";
+  case Shape::Strings:
+    return "strings";
+  case Shape::Numbers:
+    return "numbers";
+  }
+  return {};
+}
+
+/// Text mixing plain ASCII, escapes and non-ASCII, like log messages.
+inline QString sentence(QRandomGenerator &random) {
+  static const char16_t *const words[] = {
+      u"request",   u"served",      u"in",   u"ms",    u"user", u"\"admin\"",
+      u"tab\there", u"line\nbreak", u"café", u"naïve", u"日志", u"服务器",
+      u"Привет",    u"😀",          u"/api/v1/items"};
+  constexpr int wordCount = int(sizeof(words) / sizeof(*words));
+  QString text;
+  const int length = 4 + random.bounded(24);
+  for (int i = 0; i < length; ++i) {
+    if (i)
+      text += u' ';
+    text += QString::fromUtf16(words[random.bounded(wordCount)]);
+  }
+  return text;
+}
+
+inline void appendString(QByteArray &json, const QString &text) {
+  QString escaped = text;
+  escaped.replace(u'\\', QLatin1String("\\\\"))
+      .replace(u'"', QLatin1String("\\\""))
+      .replace(u'\n', QLatin1String("\\n"))
+      .replace(u'\t', QLatin1String("\\t"));
+  json += '"' + escaped.toUtf8() + '"';
+}
+
+/// Chains of nested objects, \a depth levels each, in a top-level array.
+inline QByteArray deep(int nodes, int depth = 256) {
+  QRandomGenerator random(1);
+  QByteArray json = "[";
+  for (int chain = 0; chain * depth < nodes; ++chain) {
+    if (chain)
+      json += ',';
+    for (int level = 0; level < depth; ++level)
+      json += "{\"id\":" + QByteArray::number(random.bounded(1000)) +
+              ",\"child\":";
+    json += "null";
+    json += QByteArray(depth, '}');
+  }
+  json += ']';
+  return json;
+}
+
+/// One object with \a nodes members.
+inline QByteArray wide(int nodes) {
+  QRandomGenerator random(2);
+  QByteArray json = "{";
+  for (int i = 0; i < nodes; ++i) {
+    if (i)
+      json += ',';
+    json += "\"key" + QByteArray::number(i) + "\":";
+    json += QByteArray::number(random.bounded(1000000));
+  }
+  json += '}';
+  return json;
+}
+
+/// Records whose values are mostly long strings.
+inline QByteArray strings(int nodes) {
+  QRandomGenerator random(3);
+  QByteArray json = "[";
+  for (int i = 0; i * 4 < nodes; ++i) {
+    if (i)
+      json += ',';
+    json += "{\"message\":";
+    appendString(json, sentence(random));
+    json += ",\"source\":";
+    appendString(json, sentence(random));
+    json += ",\"level\":\"info\"}";
+  }
+  json += ']';
+  return json;
+}
+
+/// Rows of integers and doubles.
+inline QByteArray numbers(int nodes) {
+  QRandomGenerator random(4);
+  QByteArray json = "[";
+  for (int row = 0; row * 17 < nodes; ++row) {
+    if (row)
+      json += ',';
+    json += '[';
+    for (int column = 0; column < 16; ++column) {
+      if (column)
+        json += ',';
+      if (column % 2)
+        json += QByteArray::number(random.generateDouble() * 1e6, 'g', 17);
+      else
+        json += QByteArray::number(qint64(random.generate64() >> 12));
+    }
+    json += ']';
+  }
+  json += ']';
+  return json;
+}
+
+inline QByteArray generate(Shape shape, int nodes) {
+  switch (shape) {
+  case Shape::Deep:
+    return deep(nodes);
+  case Shape::Wide:
+    return wide(nodes);
+  case Shape::Strings:
+    return strings(nodes);
+  case Shape::Numbers:
+    return numbers(nodes);
+  }
+  return {};
+}
+} // namespace QJsonCorpus
@@ -0,0 +1,285 @@
+/* QJsonModelBench.cpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "QJsonCorpus.hpp"
+#include "QJsonModel.hpp"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QTest>
+#include <memory>
+
+Q_DECLARE_METATYPE(QJsonCorpus::Shape)
+
+// Defined in QJsonModel.cpp, outside the public API
+void appendEscaped(QByteArray &out, const QString &s);
+
+namespace {
+using QJsonCorpus::Shape;
+
+int corpusSize = 100000;
+
+const QByteArray &corpus(Shape shape) {
+  static QHash<int, QByteArray> cache;
+  QByteArray &json = cache[int(shape)];
+  if (json.isEmpty())
+    json = QJsonCorpus::generate(shape, corpusSize);
+  return json;
+}
+
+inline uchar hexdig(uint u) { return (u < 0xa ? '0' + u : 'a' + u - 0xa); }
+
+// The escaper before the SIMD kernels, one unit at a time with a capacity
+// check per unit; the baseline of escape()
+QByteArray referenceEscape(const QString &s) {
+  QByteArray ba(s.length() + 6, Qt::Uninitialized);
+  uchar *cursor = reinterpret_cast<uchar *>(ba.data());
+  const uchar *ba_end = cursor + ba.length();
+  const ushort *src = reinterpret_cast<const ushort *>(s.constBegin());
+  const ushort *const end = reinterpret_cast<const ushort *>(s.constEnd());
+  while (src != end) {
+    if (cursor >= ba_end - 6) {
+      int pos = cursor - reinterpret_cast<const uchar *>(ba.constData());
+      ba.resize(ba.size() * 2);
+      cursor = reinterpret_cast<uchar *>(ba.data()) + pos;
+      ba_end = reinterpret_cast<const uchar *>(ba.constData()) + ba.length();
+    }
+    uint u = *src++;
+    if (u < 0x80) {
+      if (u < 0x20 || u == 0x22 || u == 0x5c) {
+        *cursor++ = '\\';
+        switch (u) {
+        case 0x22:
+          *cursor++ = '"';
+          break;
+        case 0x5c:
+          *cursor++ = '\\';
+          break;
+        case 0x8:
+          *cursor++ = 'b';
+          break;
+        case 0xc:
+          *cursor++ = 'f';
+          break;
+        case 0xa:
+          *cursor++ = 'n';
+          break;
+        case 0xd:
+          *cursor++ = 'r';
+          break;
+        case 0x9:
+          *cursor++ = 't';
+          break;
+        default:
+          *cursor++ = 'u';
+          *cursor++ = '0';
+          *cursor++ = '0';
+          *cursor++ = hexdig(u >> 4);
+          *cursor++ = hexdig(u & 0xf);
+        }
+      } else {
+        *cursor++ = (uchar)u;
+      }
+    } else if (QUtf8Functions::toUtf8<QUtf8BaseTraits>(u, cursor, src, end) <
+               0) {
+      *cursor++ = '\\';
+      *cursor++ = 'u';
+      *cursor++ = hexdig(u >> 12 & 0x0f);
+      *cursor++ = hexdig(u >> 8 & 0x0f);
+      *cursor++ = hexdig(u >> 4 & 0x0f);
+      *cursor++ = hexdig(u & 0x0f);
+    }
+  }
+  ba.resize(cursor - reinterpret_cast<const uchar *>(ba.constData()));
+  return ba;
+}
+
+// Visits every row the way a view does: both columns' display data, and
+// the parent of each index
+qint64 traverse(const QJsonModel &model, const QModelIndex &parent) {
+  qint64 visited = 0;
+  const int rows = model.rowCount(parent);
+  for (int row = 0; row < rows; ++row) {
+    const QModelIndex key = model.index(row, 0, parent);
+    const QModelIndex value = model.index(row, 1, parent);
+    visited += model.data(key, Qt::DisplayRole).isValid();
+    visited += model.data(value, Qt::DisplayRole).isValid();
+    visited += model.parent(key) == parent;
+    if (model.hasChildren(key))
+      visited += traverse(model, key);
+  }
+  return visited;
+}
+
+void collectValues(const QJsonModel &model, const QModelIndex &parent,
+                   QModelIndexList &values, int limit) {
+  const int rows = model.rowCount(parent);
+  for (int row = 0; row < rows && values.size() < limit; ++row) {
+    const QModelIndex key = model.index(row, 0, parent);
+    if (model.hasChildren(key))
+      collectValues(model, key, values, limit);
+    else
+      values.append(model.index(row, 1, parent));
+  }
+}
+} // namespace
+
+class QJsonModelBench : public QObject {
+  Q_OBJECT
+
+private:
+  void addCorpora() {
+    QTest::addColumn<Shape>("shape");
+    for (Shape shape :
+         {Shape::Deep, Shape::Wide, Shape::Strings, Shape::Numbers})
+      QTest::newRow(QJsonCorpus::shapeName(shape).constData()) << shape;
+  }
+
+private slots:
+  void initTestCase() {
+    qInfo() << "corpus size:" << corpusSize << "nodes";
+  }
+
+  void loadJson_data() { addCorpora(); }
+  void loadJson() {
+    QFETCH(Shape, shape);
+    const QByteArray &json = corpus(shape);
+    QJsonModel model;
+    QBENCHMARK { QVERIFY(model.loadJson(json)); }
+  }
+
+  void traversal_data() { addCorpora(); }
+  void traversal() {
+    QFETCH(Shape, shape);
+    QJsonModel model;
+    QVERIFY(model.loadJson(corpus(shape)));
+    qint64 visited = 0;
+    QBENCHMARK { visited = traverse(model, QModelIndex()); }
+    QVERIFY(visited > 0);
+  }
+
+  void setDataBurst_data() { addCorpora(); }
+  void setDataBurst() {
+    QFETCH(Shape, shape);
+    QJsonModel model;
+    QVERIFY(model.loadJson(corpus(shape)));
+    QModelIndexList values;
+    collectValues(model, QModelIndex(), values, 1000);
+    QVERIFY(!values.isEmpty());
+    int counter = 0;
+    QBENCHMARK {
+      for (const QModelIndex &value : std::as_const(values))
+        model.setData(value, ++counter);
+    }
+  }
+
+  void json_data() {
+    QTest::addColumn<Shape>("shape");
+    QTest::addColumn<bool>("compact");
+    for (Shape shape :
+         {Shape::Deep, Shape::Wide, Shape::Strings, Shape::Numbers}) {
+      const QByteArray name = QJsonCorpus::shapeName(shape);
+      QTest::newRow((name + "/indented").constData()) << shape << false;
+      QTest::newRow((name + "/compact").constData()) << shape << true;
+    }
+  }
+  void json() {
+    QFETCH(Shape, shape);
+    QFETCH(bool, compact);
+    QJsonModel model;
+    QVERIFY(model.loadJson(corpus(shape)));
+    QByteArray json;
+    QBENCHMARK { json = model.json(compact); }
+    QVERIFY(!json.isEmpty());
+  }
+
+  // Destruction cannot run in a QBENCHMARK loop, since each pass needs a
+  // freshly loaded model; it is timed by hand and reported the same way
+  void destruction_data() { addCorpora(); }
+  void destruction() {
+    QFETCH(Shape, shape);
+    constexpr int passes = 5;
+    qint64 elapsed = 0;
+    for (int pass = 0; pass < passes; ++pass) {
+      auto model = std::make_unique<QJsonModel>();
+      QVERIFY(model->loadJson(corpus(shape)));
+      QElapsedTimer timer;
+      timer.start();
+      model.reset();
+      elapsed += timer.nsecsElapsed();
+    }
+    QTest::setBenchmarkResult(elapsed / 1e6 / passes,
+                              QTest::WalltimeMilliseconds);
+  }
+
+  void escape_data() {
+    QTest::addColumn<QString>("text");
+    QRandomGenerator random(5);
+    QString mixed;
+    while (mixed.size() < corpusSize)
+      mixed += QJsonCorpus::sentence(random) + u' ';
+    const QString ascii =
+        QString::fromUtf16(u"The quick brown fox jumps over the lazy dog. ");
+    const QString cjk =
+        QString::fromUtf16(u"服务器日志记录完成，用户登录成功。");
+    QTest::newRow("ascii") << ascii.repeated(corpusSize / ascii.size() + 1);
+    QTest::newRow("cjk") << cjk.repeated(corpusSize / cjk.size() + 1);
+    QTest::newRow("mixed") << mixed;
+  }
+  void escape() {
+    QFETCH(QString, text);
+    QByteArray out;
+    QBENCHMARK {
+      out.clear();
+      appendEscaped(out, text);
+    }
+    QCOMPARE(out, referenceEscape(text));
+  }
+
+  void escapeReference_data() { escape_data(); }
+  void escapeReference() {
+    QFETCH(QString, text);
+    QByteArray out;
+    QBENCHMARK { out = referenceEscape(text); }
+    QVERIFY(!out.isEmpty());
+  }
+};
+
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+
+  // "-size <nodes>" scales the corpus; every other argument goes to QtTest,
+  // e.g. "-o results.xml,xml" for machine-readable output
+  QStringList arguments = app.arguments();
+  const qsizetype size = arguments.indexOf(QStringLiteral("-size"));
+  if (size > 0 && size + 1 < arguments.size()) {
+    corpusSize = qMax(1, arguments.at(size + 1).toInt());
+    arguments.remove(size, 2);
+  }
+
+  QJsonModelBench bench;
+  return QTest::qExec(&bench, arguments);
+}
+
+#include "QJsonModelBench.moc"
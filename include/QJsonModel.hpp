@@ -31,43 +31,208 @@
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QPointer>
+#include <limits>
+#include <memory>
 
+#include "details/QJsonArena.hpp"
+#include "details/QJsonChildList.hpp"
+#include "details/QJsonKeyFilter.hpp"
+#include "details/QJsonKeyPool.hpp"
+#include "details/QJsonScalar.hpp"
+#include "details/QJsonTrigramIndex.hpp"
 #include "details/QUtf8.hpp"
 
 class QJsonModel;
 class QJsonItem;
+class QThread;
+class QThreadPool;
+class QJsonTreeItem;
+
+using QJsonTreeArena = QJsonArena<QJsonTreeItem>;
+using QJsonSearchIndex = QJsonTrigramIndex<QJsonTreeItem>;
 
 class QJsonTreeItem {
 public:
+  //! Objects with fewer members are searched linearly by childByKey().
+  static constexpr int KeyIndexThreshold = 16;
+
   QJsonTreeItem(QJsonTreeItem *parent = nullptr);
   ~QJsonTreeItem();
   void appendChild(QJsonTreeItem *item);
+  void insertChild(int row, QJsonTreeItem *item);
+  //! Detaches and returns the child at \a row; ownership passes to caller.
+  QJsonTreeItem *takeChild(int row);
+  //! Removes \a count children starting at \a row, renumbering the rest
+  //! once. Heap nodes are deleted; arena nodes are only detached.
+  void removeChildren(int row, int count);
+  void insertChildren(int row, const QList<QJsonTreeItem *> &items);
+  //! Detaches all children; ownership passes to the caller.
+  QList<QJsonTreeItem *> takeChildren();
+  //! Detaches \a count children starting at \a row, renumbering the rest
+  //! once; ownership passes to the caller.
+  QList<QJsonTreeItem *> takeChildren(int row, int count);
   QJsonTreeItem *child(int row);
+  //! Object member named \a key. Objects with at least KeyIndexThreshold
+  //! members answer from a hash kept up to date by every edit.
+  QJsonTreeItem *childByKey(const QString &key);
   QJsonTreeItem *parent();
   int childCount() const;
+  //! Inserting or removing children only marks the rows after the edit as
+  //! stale; the first row() asked of one of them renumbers them all.
   int row() const;
   void setKey(const QString &key);
-  void setValue(const QVariant &value);
+  //! Converts \a value to the item's type: text that parses as a number
+  //! for numbers, "true" or "false" for bools, the text of any value but
+  //! null for strings. A null item, such as an inserted row, takes the
+  //! type of the value instead, reading text as a number or JSON literal
+  //! when it spells one. Returns false and keeps the value when it does
+  //! not convert, and for objects and arrays.
+  bool setValue(const QVariant &value);
+  void setScalar(QJsonScalar value);
   void setType(const QJsonValue::Type &type);
+  //! Array elements are usually left without a key of their own: theirs
+  //! is their row, formatted on demand.
   QString key() const;
   QVariant value() const;
+  const QJsonScalar &scalar() const;
   QJsonValue::Type type() const;
 
+  //! Builds the tree for \a value. When \a arena is given, all nodes are
+  //! allocated from it and must be released with destroyArena().
   static QJsonTreeItem *load(const QJsonValue &value,
                              const QStringList &exceptions = {},
+                             QJsonTreeItem *parent = nullptr,
+                             QJsonTreeArena *arena = nullptr);
+  //! Load state shared by the recursive load(), defined in QJsonModel.cpp.
+  struct LoadContext;
+  static QJsonTreeItem *load(const QJsonValue &value, LoadContext &context,
                              QJsonTreeItem *parent = nullptr);
+  static QJsonTreeItem *create(QJsonTreeItem *parent = nullptr,
+                               QJsonTreeArena *arena = nullptr);
+  //! Destroys every node of \a arena, including heap-allocated children
+  //! that were attached to arena nodes afterwards.
+  static void destroyArena(QJsonTreeArena &arena);
+  bool isArenaOwned() const;
+
+  //! Creates an item whose children are built on demand from \a value.
+  static QJsonTreeItem *loadLazy(const QJsonValue &value,
+                                 QJsonTreeItem *parent = nullptr);
+  //! True while the lazy source still holds children not yet materialized.
+  bool canFetchMore() const;
+  //! Builds up to \a count of the pending children. The returned items are
+  //! parented to this item but not appended yet.
+  QList<QJsonTreeItem *> fetchMore(int count,
+                                   const QJsonKeyFilter &filter = {},
+                                   QJsonKeyPool *keys = nullptr);
+  //! Builds the remaining pending children without consuming them.
+  QList<QJsonTreeItem *>
+  pendingChildren(const QJsonKeyFilter &filter = {}) const;
+  //! Estimated bytes of the node itself: the object, its child list, key
+  //! hash and lazy source. Keys and values are not included.
+  qsizetype nodeBytes() const;
 
 protected:
 private:
+  friend class QJsonTreeBuilder;
+
+  void loadChildren(const QJsonValue &value, LoadContext &context);
+  //! Sorts the members unless \a keepOrder and drops overwritten duplicate
+  //! keys, leaving the object as QJsonObject would hold it.
+  void finishObject(bool keepOrder);
+  void buildKeyIndex();
+  void indexKey(QJsonTreeItem *child);
+  void unindexKey(QJsonTreeItem *child);
+  QList<QJsonTreeItem *> buildChildren(qsizetype &offset, int count,
+                                       const QJsonKeyFilter &filter,
+                                       QJsonKeyPool *keys) const;
+  //! State of \a filter's path rules at this item, from its ancestors.
+  QJsonKeyFilter::State filterState(const QJsonKeyFilter &filter) const;
+  void markRowsStale(int row);
+  void renumberRows() const;
+
+  static constexpr int NoStaleRow = std::numeric_limits<int>::max();
+
+  struct LazySource {
+    QJsonValue source;
+    qsizetype offset = 0;
+  };
+
+  //! State few nodes need, kept out of line so that the others pay one
+  //! pointer for it. Created on first use, freed with the node.
+  struct Extra {
+    //! Pending source of a lazily loaded array or object.
+    std::unique_ptr<LazySource> lazy;
+    //! Members by key; only objects with many members have one.
+    std::unique_ptr<QHash<QString, QJsonTreeItem *>> keyIndex;
+    //! Children from this row on may hold an outdated mRow.
+    int firstStaleRow = NoStaleRow;
+    //! Index in the source array of a lazily built array element, which
+    //! differs from its row after skipped elements or edits.
+    qsizetype sourceIndex = -1;
+  };
+
+  Extra &extra();
+  LazySource *lazySource() const;
+  QHash<QString, QJsonTreeItem *> *keyIndex() const;
+  int firstStaleRow() const;
+  qsizetype sourceIndex() const;
+
   QString mKey;
-  QVariant mValue;
-  QJsonValue::Type mType;
-  QList<QJsonTreeItem *> mChilds;
+  QJsonScalar mValue;
+  QJsonChildList<QJsonTreeItem> mChilds;
   QJsonTreeItem *mParent = nullptr;
+  Extra *mExtra = nullptr;
+  //! Position in mParent->mChilds, valid below its firstStaleRow().
+  mutable int mRow = 0;
+  //! A QJsonValue::Type; every value fits a byte.
+  quint8 mType = QJsonValue::Null;
+  bool mArenaOwned = false;
 };
 
 //---------------------------------------------------
 
+//! Figures gathered while QJsonModel::setStatisticsEnabled() is on. Phase
+//! timings are in nanoseconds and describe the last load or serialization;
+//! the call counters add up until QJsonModel::resetStatistics().
+struct QJsonModelStatistics {
+  //! Reading or mapping the file of load() and loadAsync().
+  qint64 readNs = 0;
+  //! QJsonDocument::fromJson() of a lazy load. The native parser creates
+  //! nodes as it parses, so its time is all in buildNs.
+  qint64 parseNs = 0;
+  //! Creating the tree nodes.
+  qint64 buildNs = 0;
+  //! Model reset or incremental merge, and the search index rebuild.
+  qint64 installNs = 0;
+  qint64 loadedBytes = 0;
+  //! Last json() or save().
+  qint64 serializeNs = 0;
+  qint64 serializedBytes = 0;
+
+  //! Nodes of the current tree by type, as of the last load or
+  //! serialization. Children a lazy view has not fetched are not counted.
+  qint64 objects = 0;
+  qint64 arrays = 0;
+  qint64 strings = 0;
+  qint64 numbers = 0;
+  qint64 bools = 0;
+  qint64 nulls = 0;
+  //! Levels between the root and its deepest node; 0 for an empty root.
+  qint64 depth = 0;
+  //! Estimated heap bytes of key strings, each shared key counted once.
+  qint64 keyBytes = 0;
+  //! Estimated heap bytes of string values, and of numbers kept as text.
+  qint64 valueBytes = 0;
+  //! Estimated bytes of the nodes themselves (QJsonTreeItem::nodeBytes()).
+  qint64 nodeBytes = 0;
+
+  //! Calls from views since the last reset.
+  qint64 dataCalls = 0;
+  qint64 indexCalls = 0;
+  qint64 parentCalls = 0;
+};
+
 class QJsonModel : public QAbstractItemModel {
   Q_OBJECT
 public:
@@ -76,12 +241,131 @@ public:
   QJsonModel(QIODevice *device, QObject *parent = nullptr);
   QJsonModel(const QByteArray &json, QObject *parent = nullptr);
   ~QJsonModel();
+  //! Encodings load() and save() read and write.
+  enum class Format { Json, Cbor };
   bool load(const QString &fileName);
-  bool load(QIODevice *device);
+  bool load(QIODevice *device, Format format = Format::Json);
+  //! Parses \a json with the built-in streaming parser, which creates the
+  //! nodes directly from the UTF-8 text. Lazy loading goes through
+  //! QJsonDocument instead, since it keeps the parsed values as its source.
   bool loadJson(const QByteArray &json);
+  //! Builds the tree from a CBOR document whose top level is a map or an
+  //! array, without going through JSON text. Byte strings become base64url
+  //! text (base64 or hex when tagged so), other tags are dropped in favour
+  //! of the value they wrap, and non-text map keys become their diagnostic
+  //! notation. Integers beyond qint64 keep their exact digits.
+  bool loadCbor(const QByteArray &cbor);
+  //! Error of the last failed load, with the byte offset where it stopped.
+  QJsonParseError parseError() const;
+  //! Reads, parses and builds \a fileName on a worker thread, then swaps
+  //! the result in with a single model reset. Returns false if the file
+  //! does not exist; otherwise loadFinished() reports the outcome.
+  bool loadAsync(const QString &fileName);
+  void cancelLoad();
+  bool isLoading() const;
+  //! Builds children only when a view asks for them (see fetchMore()).
+  void setLazyLoading(bool enabled);
+  bool lazyLoading() const;
+  //! Number of children materialized per fetchMore() call in lazy mode.
+  void setFetchBatchSize(int size);
+  int fetchBatchSize() const;
+  //! Keeps object keys in document order instead of QJsonObject's sorted
+  //! order, so json() and save() reproduce the loaded layout.
+  void setPreserveKeyOrder(bool enabled);
+  bool preserveKeyOrder() const;
+  //! Makes load(fileName) and loadAsync() parse straight from a memory
+  //! mapping of the file instead of reading it into a buffer first. This
+  //! saves the copy of the whole file only: keys and strings are decoded
+  //! into nodes of their own as usual, and the file is unmapped once the
+  //! load returns. Files that cannot be mapped are read as before.
+  void setMemoryMapping(bool enabled);
+  bool memoryMapping() const;
+  //! Arrays and objects with at least \a children entries are built by
+  //! several threads at once.
+  void setParallelThreshold(int children);
+  int parallelThreshold() const;
+  //! Threads used to build wide containers; 0 (the default) uses
+  //! QThread::idealThreadCount() and 1 disables parallel building.
+  void setLoadThreadCount(int threads);
+  int loadThreadCount() const;
+  //! Switches to JSON Lines mode: the root becomes an empty array and each
+  //! record read from \a device (a file or a pipe) is appended to it as a
+  //! top-level row as data arrives. Pass nullptr to detach.
+  void setNdjsonDevice(QIODevice *device);
+  //! Reads whatever the attached device has buffered. Called on readyRead;
+  //! call it directly for devices that never emit it, such as QFile.
+  void readNdjson();
+  //! Queues the complete lines of \a data as records; a trailing partial
+  //! line waits for the rest. Records reach the model in batches, one row
+  //! insertion per event loop pass (see setNdjsonFlushInterval()).
+  void appendNdjson(const QByteArray &data);
+  //! Inserts the queued records now.
+  void flushNdjson();
+  //! Delay in ms before queued records are inserted, so that records
+  //! trickling in line by line still share one insertion.
+  void setNdjsonFlushInterval(int msec);
+  int ndjsonFlushInterval() const;
+  //! Keeps at most \a rows top-level records, dropping the oldest ones as
+  //! new ones arrive. 0 (the default) keeps everything.
+  void setMaxRows(int rows);
+  int maxRows() const;
+  //! Makes a load into a populated model update it in place: the new
+  //! document is diffed against the current tree, objects by key and arrays
+  //! by index, and only the rows and values that differ are signalled.
+  //! Views keep their expansion, selection and scroll state.
+  //! Nodes of the initial load live in the model's arena, which cannot free
+  //! them one by one: those a merge removes stay allocated until a model
+  //! reset replaces the tree. When reloads keep dropping large parts of the
+  //! document, turn this off for one load now and then to reclaim them.
+  void setIncrementalReload(bool enabled);
+  bool incrementalReload() const;
+  //! Estimated heap bytes the current tree avoids by sharing repeated
+  //! object keys and deriving array indices from the row.
+  qint64 keyBytesSaved() const;
+  //! Index of the item at the JSON Pointer \a path, e.g.
+  //! "/services/42/limits/cpu", with one hash probe or row lookup per
+  //! segment. Lazy children are fetched on the way. Invalid when nothing is
+  //! there, and for "", which is the root.
+  QModelIndex indexForPath(const QString &path);
+  //! JSON Pointer of \a index; the inverse of indexForPath().
+  QString pathForIndex(const QModelIndex &index) const;
+  //! Searches keys and scalar values for \a pattern, compared as \a flags
+  //! say: contains, starts or ends with, fixed string, wildcard or regular
+  //! expression, ignoring case unless Qt::MatchCaseSensitive is set. Worker
+  //! threads report matches through searchResults() in batches as they are
+  //! found, in no particular order, then searchFinished(). Children a lazy
+  //! view has not fetched are not searched. A new search or any edit of the
+  //! model cancels the running one. Returns the id the signals carry.
+  int find(const QString &pattern, Qt::MatchFlags flags = Qt::MatchContains);
+  void cancelFind();
+  bool isFinding() const;
+  //! Keeps a trigram index of keys and values, built with each load and
+  //! updated by setData(). Searches for substrings of three characters or
+  //! more then only check the items the index points at.
+  void setSearchIndexEnabled(bool enabled);
+  bool searchIndexEnabled() const;
+  //! Collects load and serialization timings, tree figures and view call
+  //! counters (see QJsonModelStatistics), reported by statisticsUpdated()
+  //! after each load, json() and save(). Off by default; while off, the
+  //! counters cost one predictable branch per call.
+  void setStatisticsEnabled(bool enabled);
+  bool statisticsEnabled() const;
+  QJsonModelStatistics statistics() const;
+  void resetStatistics();
   QVariant data(const QModelIndex &index, int role) const override;
   bool setData(const QModelIndex &index, const QVariant &value,
                int role = Qt::EditRole) override;
+  //! Edits made by setData() between beginBatch() and the matching
+  //! commitBatch() emit no signal of their own. The commit reports them as
+  //! one dataChanged() per run of consecutive rows under a parent; edits
+  //! pending when rows are removed or the model is reset are reported
+  //! first. Batches nest: only the outermost commit emits.
+  void beginBatch();
+  void commitBatch();
+  //! Applies \a edits as one batch. Returns false if any edit was refused;
+  //! the others are applied all the same.
+  bool setDataBatch(const QList<QPair<QModelIndex, QVariant>> &edits,
+                    int role = Qt::EditRole);
   QVariant headerData(int section, Qt::Orientation orientation,
                       int role) const override;
   QModelIndex index(int row, int column,
@@ -89,27 +373,170 @@ public:
   QModelIndex parent(const QModelIndex &index) const override;
   int rowCount(const QModelIndex &parent = QModelIndex()) const override;
   int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+  bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+  bool canFetchMore(const QModelIndex &parent) const override;
+  void fetchMore(const QModelIndex &parent) override;
   Qt::ItemFlags flags(const QModelIndex &index) const override;
+  //! Structural edits of arrays and objects. New rows hold null until
+  //! setData() gives them a value, whose type they take; in an object they
+  //! get free keys "key1", "key2"... Array elements moved into
+  //! an object take their former index as key, and moves that would repeat
+  //! a key of the destination object are refused. Children a lazy view has
+  //! not fetched yet are built first.
+  bool insertRows(int row, int count,
+                  const QModelIndex &parent = QModelIndex()) override;
+  bool removeRows(int row, int count,
+                  const QModelIndex &parent = QModelIndex()) override;
+  bool moveRows(const QModelIndex &sourceParent, int sourceRow, int count,
+                const QModelIndex &destinationParent,
+                int destinationChild) override;
+  //! Inserts \a value, whole subtree included, at \a row of the array or
+  //! object at \a parent; -1 appends. In an object the member is named
+  //! \a key, or a free key when it is empty. Returns the index of the new
+  //! row, invalid if \a parent is no container or \a key is taken.
+  QModelIndex insertValue(const QModelIndex &parent, int row,
+                          const QJsonValue &value, const QString &key = {});
+  //! Records setData() and the structural edits above so that they can be
+  //! undone, keeping the last \a limit steps; 0, the default, records
+  //! nothing. Each edit keeps the value it replaced or the nodes it
+  //! detached, never a copy of the tree. Loads, resets and trimmed NDJSON
+  //! rows clear the history.
+  void setUndoLimit(int limit);
+  int undoLimit() const;
+  //! Ends the current undo step: undo() reverts the edits made since the
+  //! previous snapshot() together.
+  void snapshot();
+  bool canUndo() const;
+  bool canRedo() const;
+  //! Reverts the last step, or redoes the last undone one, with the same
+  //! row signals as the edits and coalesced dataChanged() ranges.
+  bool undo();
+  bool redo();
+  void clearUndoHistory();
   QByteArray json(bool compact = false);
+  //! Encodes the tree as CBOR. Numbers go out as integers when they are
+  //! ones, so big integers loaded by loadCbor() round-trip exactly.
+  QByteArray cbor();
+  //! Writes the tree to \a fileName in a binary form that loadSnapshot()
+  //! maps and rebuilds without parsing. \a sourceFile is the JSON file the
+  //! tree came from: its size and modification time are recorded.
+  bool saveSnapshot(const QString &fileName, const QString &sourceFile);
+  //! Loads a snapshot written by saveSnapshot(), replacing the tree. Fails,
+  //! leaving the model as it is, when the snapshot is damaged or of another
+  //! format version, or \a sourceFile changed since it was written; load
+  //! the JSON itself then, and save a fresh snapshot.
+  bool loadSnapshot(const QString &fileName, const QString &sourceFile);
+  //! Writes the tree to \a device in chunks, without building a QJsonValue.
+  bool save(const QString &fileName, bool compact = false);
+  bool save(QIODevice *device, bool compact = false);
+  bool save(const QString &fileName, Format format);
+  bool save(QIODevice *device, Format format);
   QByteArray jsonToByte(QJsonValue jsonValue);
-  void objectToJson(QJsonObject jsonObject, QByteArray &json, int indent,
-                    bool compact);
-  void arrayToJson(QJsonArray jsonArray, QByteArray &json, int indent,
+  void objectToJson(const QJsonObject &jsonObject, QByteArray &json,
+                    int indent, bool compact);
+  void arrayToJson(const QJsonArray &jsonArray, QByteArray &json, int indent,
                    bool compact);
-  void arrayContentToJson(QJsonArray jsonArray, QByteArray &json, int indent,
-                          bool compact);
-  void objectContentToJson(QJsonObject jsonObject, QByteArray &json, int indent,
-                           bool compact);
-  void valueToJson(QJsonValue jsonValue, QByteArray &json, int indent,
+  void arrayContentToJson(const QJsonArray &jsonArray, QByteArray &json,
+                          int indent, bool compact);
+  void objectContentToJson(const QJsonObject &jsonObject, QByteArray &json,
+                           int indent, bool compact);
+  void valueToJson(const QJsonValue &jsonValue, QByteArray &json, int indent,
                    bool compact);
-  //! List of tags to skip during JSON parsing
+  //! List of tags to skip during JSON parsing. Entries starting with '/'
+  //! are JSON Pointers to subtrees, with "*" and "**" wildcards; the others
+  //! skip every member whose key contains them (see QJsonKeyFilter).
   void addException(const QStringList &exceptions);
 
+signals:
+  //! Emitted from the loading thread. \a nodes stays 0 while reading.
+  void loadProgress(qint64 bytesRead, qint64 bytesTotal, qint64 nodes);
+  void loadFinished(bool success);
+  void searchResults(int search, const QModelIndexList &indexes);
+  void searchFinished(int search, qint64 matches);
+  void statisticsUpdated(const QJsonModelStatistics &statistics);
+  void canUndoChanged(bool canUndo);
+  void canRedoChanged(bool canRedo);
+
 private:
-  QJsonValue genJson(QJsonTreeItem *) const;
+  struct AsyncLoad;
+  struct Search;
+  struct UndoHistory;
+
+  void releaseTree();
+  void configure(QJsonTreeItem::LoadContext &context) const;
+  void startNdjson();
+  bool canMerge() const;
+  bool installTree(QJsonTreeItem *root, QJsonTreeArena &arena, bool lazy);
+  void mergeItem(QJsonTreeItem *item, QJsonTreeItem *fresh,
+                 const QModelIndex &index);
+  void mergeChildren(QJsonTreeItem *item, QJsonTreeItem *fresh,
+                     const QModelIndex &parent);
+  void trimRows(int keep);
+  void invalidateSearch();
+  void rebuildSearchIndex();
+  void deliverResults(const std::shared_ptr<Search> &search,
+                      const QList<QJsonTreeItem *> &items);
+  void finishSearch(const std::shared_ptr<Search> &search);
+  void reportStatistics();
+  void flushBatch();
+  QJsonTreeItem *containerItem(const QModelIndex &parent);
+  QModelIndex indexOf(QJsonTreeItem *item) const;
+  void insertItems(QJsonTreeItem *parent, int row,
+                   const QList<QJsonTreeItem *> &items);
+  QList<QJsonTreeItem *> takeItems(QJsonTreeItem *parent, int row, int count);
+  bool moveItems(QJsonTreeItem *from, int row, int count, QJsonTreeItem *to,
+                 int target, const QStringList &keys);
+  bool replaySteps(bool undo);
+  void reportUndoState();
   QJsonTreeItem *mRootItem = nullptr;
+  //! Node storage of the tree built by loadJson().
+  QJsonTreeArena mArena;
   QStringList mHeaders;
-  //! List of exceptions (e.g. comments). Case insensitive, compairs on
-  //! "contains".
-  QStringList mExceptions;
+  //! Exceptions (e.g. comments), compiled by addException().
+  QJsonKeyFilter mFilter;
+  bool mLazyLoading = false;
+  int mFetchBatchSize = 256;
+  bool mPreserveKeyOrder = false;
+  bool mMemoryMapping = false;
+  QJsonParseError mParseError;
+  int mParallelThreshold = 8192;
+  int mLoadThreadCount = 0;
+  std::shared_ptr<AsyncLoad> mAsyncLoad;
+  QThread *mLoadThread = nullptr;
+  QPointer<QIODevice> mNdjsonDevice;
+  //! Partial last line, waiting for its newline.
+  QByteArray mNdjsonBuffer;
+  //! Parsed records not yet inserted into the root.
+  QList<QJsonTreeItem *> mNdjsonPending;
+  //! Records seen since NDJSON mode started; keys them across trimming.
+  qint64 mNdjsonRecords = 0;
+  bool mNdjsonFlushQueued = false;
+  int mNdjsonFlushInterval = 0;
+  int mMaxRows = 0;
+  bool mIncrementalReload = false;
+  //! Keys of records added after the load (JSON Lines, lazy fetches).
+  QJsonKeyPool mKeys;
+  qint64 mKeyBytesSaved = 0;
+  //! Whether the current tree still has children waiting for fetchMore().
+  bool mLazyTree = false;
+  //! Only touched by the GUI thread after cancelFind(), or by the search
+  //! worker that rebuilds it.
+  QJsonSearchIndex mSearchIndex;
+  bool mSearchIndexEnabled = false;
+  //! Set when the tree changed in ways the index cannot follow; the next
+  //! search rebuilds it.
+  bool mSearchIndexStale = false;
+  std::shared_ptr<Search> mSearch;
+  QThreadPool *mSearchPool = nullptr;
+  int mSearchId = 0;
+  bool mStatisticsEnabled = false;
+  //! Mutable for the call counters of data(), index() and parent().
+  mutable QJsonModelStatistics mStatistics;
+  //! Read time of a load() on its way to loadJson().
+  qint64 mReadNs = 0;
+  int mBatchDepth = 0;
+  //! Items edited in the open batch, in edit order, possibly repeated.
+  QList<QJsonTreeItem *> mBatchItems;
+  //! Null while undo is off.
+  std::unique_ptr<UndoHistory> mUndo;
 };
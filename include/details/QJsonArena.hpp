@@ -0,0 +1,103 @@
+/* QJsonArena.hpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <QList>
+#include <new>
+#include <utility>
+
+/// Bump allocator keeping objects of type \a T contiguous in large blocks.
+/// Objects are never freed one by one: clear() runs every destructor in
+/// creation order and then releases the blocks in one go.
+template <typename T> class QJsonArena {
+public:
+  QJsonArena() = default;
+  QJsonArena(const QJsonArena &) = delete;
+  QJsonArena &operator=(const QJsonArena &) = delete;
+  ~QJsonArena() { clear(); }
+
+  template <typename... Args> T *create(Args &&...args) {
+    if (mBlocks.isEmpty() || mBlocks.last().used == mBlocks.last().capacity)
+      grow();
+    Block &block = mBlocks.last();
+    T *object = new (block.data + block.used) T(std::forward<Args>(args)...);
+    ++block.used;
+    ++mCount;
+    return object;
+  }
+
+  /// Calls \a f on every live object, in creation order.
+  template <typename F> void forEach(F f) {
+    for (const Block &block : std::as_const(mBlocks))
+      for (qsizetype i = 0; i < block.used; ++i)
+        f(block.data[i]);
+  }
+
+  /// Takes over all objects of \a other, which is left empty.
+  void merge(QJsonArena &other) {
+    mBlocks.append(other.mBlocks);
+    mCount += other.mCount;
+    other.mBlocks.clear();
+    other.mCount = 0;
+  }
+
+  void clear() {
+    for (const Block &block : std::as_const(mBlocks)) {
+      for (qsizetype i = 0; i < block.used; ++i)
+        block.data[i].~T();
+      ::operator delete(block.data);
+    }
+    mBlocks.clear();
+    mCount = 0;
+  }
+
+  qsizetype count() const { return mCount; }
+
+  /// Bytes reserved by the blocks, used or not.
+  qsizetype capacityBytes() const {
+    qsizetype bytes = 0;
+    for (const Block &block : mBlocks)
+      bytes += block.capacity * qsizetype(sizeof(T));
+    return bytes;
+  }
+
+private:
+  struct Block {
+    T *data;
+    qsizetype used;
+    qsizetype capacity;
+  };
+
+  void grow() {
+    // Start small for tiny documents, double up to a fixed block size
+    qsizetype capacity = mBlocks.isEmpty() ? 256 : mBlocks.last().capacity * 2;
+    capacity = qMin<qsizetype>(capacity, 64 * 1024);
+    T *data = static_cast<T *>(::operator new(sizeof(T) * capacity));
+    mBlocks.append({data, 0, capacity});
+  }
+
+  QList<Block> mBlocks;
+  qsizetype mCount = 0;
+};
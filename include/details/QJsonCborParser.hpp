@@ -0,0 +1,280 @@
+/* QJsonCborParser.hpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QCborStreamReader>
+#include <QCborValue>
+#include <QString>
+#include <limits>
+#include <utility>
+
+#include "QJsonSaxParser.hpp"
+
+/// Event-driven CBOR reader for QJsonSaxParser handlers, so that a CBOR
+/// document builds the same nodes as its JSON text would. Besides the
+/// QJsonSaxParser events, \a Handler gets the numbers CBOR holds in binary:
+///
+///   bool integer(qint64 value);
+///   bool real(double value);
+///
+/// Integers beyond qint64 still arrive through number(), as their text.
+/// CBOR types JSON lacks are mapped as QCborValue::toJsonValue() maps them:
+///
+/// - byte strings become base64url text, or base64 or hex text when tagged
+///   as expected to be (tags 22 and 23);
+/// - other tags are dropped for the value they wrap;
+/// - undefined becomes null, other simple values the text "simple(N)";
+/// - map keys that are not text become text: integers their digits,
+///   anything else its diagnostic notation.
+template <typename Handler> class QJsonCborParser {
+public:
+  static constexpr int MaxDepth = 1024;
+
+  QJsonCborParser(const QByteArray &data, Handler &handler)
+      : mReader(data), mSize(data.size()), mHandler(handler) {}
+
+  /// Parses a whole document; the top-level value must be a map or an
+  /// array, as for QJsonDocument.
+  bool parseDocument() {
+    if (!skipTags())
+      return false;
+    if (!mReader.isMap() && !mReader.isArray())
+      return fail(QCborError::IllegalType);
+    if (!parseValue(true))
+      return false;
+    if (mReader.currentOffset() != mSize)
+      return fail(QCborError::GarbageAtEnd);
+    return true;
+  }
+
+  /// QCborError::NoError after a parse stopped by the handler.
+  QCborError error() const { return mError; }
+  qint64 errorOffset() const { return mErrorOffset; }
+
+private:
+  enum Encoding { Base64Url, Base64, Base16 };
+
+  bool fail(QCborError::Code code) {
+    mError = {code};
+    mErrorOffset = mReader.currentOffset();
+    return false;
+  }
+
+  /// Fails with the reader's error, if it has one.
+  bool check() {
+    const QCborError error = mReader.lastError();
+    return error == QCborError::NoError ? true : fail(error.c);
+  }
+
+  /// Steps over tags, returning the encoding the last one asks of a byte
+  /// string in \a encoding.
+  bool skipTags(Encoding *encoding = nullptr) {
+    while (mReader.isTag()) {
+      const QCborTag tag = mReader.toTag();
+      if (encoding && tag == QCborTag(QCborKnownTags::ExpectedBase64))
+        *encoding = Base64;
+      else if (encoding && tag == QCborTag(QCborKnownTags::ExpectedBase16))
+        *encoding = Base16;
+      if (!mReader.next())
+        return check();
+    }
+    return check();
+  }
+
+  bool readString(QString &text) {
+    auto chunk = mReader.readString();
+    while (chunk.status == QCborStreamReader::Ok) {
+      text += chunk.data;
+      chunk = mReader.readString();
+    }
+    return chunk.status == QCborStreamReader::EndOfString || check();
+  }
+
+  bool readByteArray(QByteArray &bytes) {
+    auto chunk = mReader.readByteArray();
+    while (chunk.status == QCborStreamReader::Ok) {
+      bytes += chunk.data;
+      chunk = mReader.readByteArray();
+    }
+    return chunk.status == QCborStreamReader::EndOfString || check();
+  }
+
+  /// Text of the integer -\a magnitude, which qint64 may not hold. The
+  /// reader gives -2^64 a magnitude of 0.
+  static QByteArray negativeText(quint64 magnitude) {
+    if (magnitude == 0)
+      return "-18446744073709551616";
+    return '-' + QByteArray::number(magnitude);
+  }
+
+  bool parseKey(QString &key) {
+    if (!skipTags())
+      return false;
+    if (mReader.isString())
+      return readString(key);
+
+    if (mReader.isUnsignedInteger()) {
+      key = QString::number(mReader.toUnsignedInteger());
+    } else if (mReader.isNegativeInteger()) {
+      key = QString::fromLatin1(
+          negativeText(quint64(mReader.toNegativeInteger())));
+    } else {
+      const QCborValue value = QCborValue::fromCbor(mReader);
+      if (!check())
+        return false;
+      key = value.isByteArray()
+                ? QString::fromLatin1(value.toByteArray().toBase64(
+                      QByteArray::Base64UrlEncoding |
+                      QByteArray::OmitTrailingEquals))
+                : value.toDiagnosticNotation(QCborValue::Compact);
+      return true;
+    }
+    mReader.next();
+    return check();
+  }
+
+  /// Parses one value; a value not \a accepted is stepped over whole.
+  bool parseValue(bool accepted) {
+    Encoding encoding = Base64Url;
+    if (!skipTags(&encoding))
+      return false;
+    if (!accepted) {
+      mReader.next();
+      return check();
+    }
+
+    switch (mReader.type()) {
+    case QCborStreamReader::UnsignedInteger: {
+      const quint64 value = mReader.toUnsignedInteger();
+      mReader.next();
+      if (!check())
+        return false;
+      if (value <= quint64(std::numeric_limits<qint64>::max()))
+        return mHandler.integer(qint64(value));
+      const QByteArray text = QByteArray::number(value);
+      return mHandler.number(text.constData(), text.size(), true);
+    }
+    case QCborStreamReader::NegativeInteger: {
+      const quint64 magnitude = quint64(mReader.toNegativeInteger());
+      mReader.next();
+      if (!check())
+        return false;
+      if (magnitude != 0 &&
+          magnitude - 1 <= quint64(std::numeric_limits<qint64>::max()))
+        return mHandler.integer(-qint64(magnitude - 1) - 1);
+      const QByteArray text = negativeText(magnitude);
+      return mHandler.number(text.constData(), text.size(), true);
+    }
+    case QCborStreamReader::Float16:
+    case QCborStreamReader::Float:
+    case QCborStreamReader::Double: {
+      const QCborStreamReader::Type type = mReader.type();
+      const double value = type == QCborStreamReader::Double
+                               ? mReader.toDouble()
+                           : type == QCborStreamReader::Float
+                               ? double(mReader.toFloat())
+                               : double(mReader.toFloat16());
+      mReader.next();
+      return check() && mHandler.real(value);
+    }
+    case QCborStreamReader::SimpleType: {
+      const QCborSimpleType simple = mReader.toSimpleType();
+      mReader.next();
+      if (!check())
+        return false;
+      switch (simple) {
+      case QCborSimpleType::False:
+        return mHandler.boolean(false);
+      case QCborSimpleType::True:
+        return mHandler.boolean(true);
+      case QCborSimpleType::Null:
+      case QCborSimpleType::Undefined:
+        return mHandler.null();
+      default:
+        return mHandler.string(QStringLiteral("simple(%1)").arg(int(simple)));
+      }
+    }
+    case QCborStreamReader::ByteArray: {
+      QByteArray bytes;
+      if (!readByteArray(bytes))
+        return false;
+      const QByteArray text =
+          encoding == Base16   ? bytes.toHex()
+          : encoding == Base64 ? bytes.toBase64()
+                               : bytes.toBase64(QByteArray::Base64UrlEncoding |
+                                                QByteArray::OmitTrailingEquals);
+      return mHandler.string(QString::fromLatin1(text));
+    }
+    case QCborStreamReader::String: {
+      QString text;
+      return readString(text) && mHandler.string(std::move(text));
+    }
+    case QCborStreamReader::Array:
+    case QCborStreamReader::Map:
+      return parseContainer(mReader.isMap());
+    default:
+      return fail(QCborError::UnknownType);
+    }
+  }
+
+  bool parseContainer(bool isMap) {
+    if (++mDepth > MaxDepth)
+      return fail(QCborError::NestingTooDeep);
+    if (!(isMap ? mHandler.startObject() : mHandler.startArray()))
+      return false;
+    if (!mReader.enterContainer())
+      return check() && fail(QCborError::UnknownError);
+
+    while (mReader.hasNext()) {
+      QJsonSax::KeyAction action;
+      if (isMap) {
+        QString key;
+        if (!parseKey(key))
+          return false;
+        action = mHandler.key(std::move(key));
+      } else {
+        action = mHandler.element();
+      }
+      if (action == QJsonSax::Abort || !parseValue(action == QJsonSax::Accept))
+        return false;
+    }
+    // The loop also ends on errors
+    if (!check())
+      return false;
+    if (!mReader.leaveContainer())
+      return check() && fail(QCborError::UnknownError);
+
+    --mDepth;
+    return isMap ? mHandler.endObject() : mHandler.endArray();
+  }
+
+  QCborStreamReader mReader;
+  const qint64 mSize;
+  Handler &mHandler;
+  int mDepth = 0;
+  QCborError mError = {QCborError::NoError};
+  qint64 mErrorOffset = 0;
+};
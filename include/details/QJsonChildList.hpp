@@ -0,0 +1,133 @@
+/* QJsonChildList.hpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <QList>
+#include <QtGlobal>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <utility>
+
+/// Array of child pointers: one pointer and two ints, 16 bytes where a
+/// QList takes 24. Every node holds one, scalars included, so the saving
+/// applies to the whole tree. Rows are ints in the model, so are sizes.
+template <typename T> class QJsonChildList {
+public:
+  QJsonChildList() = default;
+  QJsonChildList(const QJsonChildList &) = delete;
+  QJsonChildList &operator=(const QJsonChildList &) = delete;
+  QJsonChildList(QJsonChildList &&other) noexcept
+      : mData(std::exchange(other.mData, nullptr)),
+        mSize(std::exchange(other.mSize, 0)),
+        mCapacity(std::exchange(other.mCapacity, 0)) {}
+  QJsonChildList &operator=(QJsonChildList &&other) noexcept {
+    if (this != &other) {
+      std::free(mData);
+      mData = std::exchange(other.mData, nullptr);
+      mSize = std::exchange(other.mSize, 0);
+      mCapacity = std::exchange(other.mCapacity, 0);
+    }
+    return *this;
+  }
+  ~QJsonChildList() { std::free(mData); }
+
+  int size() const { return mSize; }
+  int capacity() const { return mCapacity; }
+  bool isEmpty() const { return mSize == 0; }
+
+  T *at(qsizetype i) const {
+    Q_ASSERT(i >= 0 && i < mSize);
+    return mData[i];
+  }
+  T *&operator[](qsizetype i) {
+    Q_ASSERT(i >= 0 && i < mSize);
+    return mData[i];
+  }
+  /// Null for rows out of range, like QList::value().
+  T *value(qsizetype i) const {
+    return i >= 0 && i < mSize ? mData[i] : nullptr;
+  }
+
+  T **begin() { return mData; }
+  T **end() { return mData + mSize; }
+  T *const *begin() const { return mData; }
+  T *const *end() const { return mData + mSize; }
+
+  void reserve(qsizetype capacity) {
+    if (capacity > mCapacity)
+      reallocate(capacity);
+  }
+
+  void append(T *item) { insert(mSize, 1, item); }
+  void insert(qsizetype i, T *item) { insert(i, 1, item); }
+  /// Inserts \a count copies of \a item before row \a i.
+  void insert(qsizetype i, qsizetype count, T *item) {
+    Q_ASSERT(i >= 0 && i <= mSize && count >= 0);
+    if (mSize + count > mCapacity)
+      reallocate(qMax<qsizetype>(mSize + count, qMax(4, 2 * mCapacity)));
+    std::memmove(mData + i + count, mData + i, (mSize - i) * sizeof(T *));
+    for (qsizetype k = 0; k < count; ++k)
+      mData[i + k] = item;
+    mSize += int(count);
+  }
+
+  void remove(qsizetype i, qsizetype count) {
+    Q_ASSERT(i >= 0 && count >= 0 && i + count <= mSize);
+    std::memmove(mData + i, mData + i + count,
+                 (mSize - i - count) * sizeof(T *));
+    mSize -= int(count);
+  }
+  T *takeAt(qsizetype i) {
+    T *item = at(i);
+    remove(i, 1);
+    return item;
+  }
+
+  QList<T *> mid(qsizetype i, qsizetype count) const {
+    Q_ASSERT(i >= 0 && count >= 0 && i + count <= mSize);
+    return QList<T *>(mData + i, mData + i + count);
+  }
+  QList<T *> toList() const { return mid(0, mSize); }
+
+  /// Also releases the storage, as QList::clear() does.
+  void clear() {
+    std::free(std::exchange(mData, nullptr));
+    mSize = mCapacity = 0;
+  }
+
+private:
+  void reallocate(qsizetype capacity) {
+    Q_ASSERT(capacity <= std::numeric_limits<int>::max());
+    T **data = static_cast<T **>(std::realloc(mData, capacity * sizeof(T *)));
+    Q_CHECK_PTR(data);
+    mData = data;
+    mCapacity = int(capacity);
+  }
+
+  T **mData = nullptr;
+  int mSize = 0;
+  int mCapacity = 0;
+};
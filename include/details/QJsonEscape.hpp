@@ -0,0 +1,224 @@
+/* QJsonEscape.hpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <QChar>
+#include <QtAlgorithms>
+#include <QtGlobal>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                  \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define QJSONESCAPE_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__)
+// GCC and Clang can build AVX2 functions in an otherwise baseline binary
+#define QJSONESCAPE_AVX2
+#include <immintrin.h>
+#endif
+#endif
+
+/// Kernels measuring the runs of a UTF-16 string that JSON output writes
+/// without escapes. Both return the length of the run at the start of
+/// \a src, at most \a n units:
+///
+/// - plainRun(): printable ASCII other than '"' and '\\', copied byte for
+///   byte; when \a dst is not null the run is also narrowed into it.
+/// - textRun(): also non-ASCII units, which only need transcoding, up to
+///   the next escape or surrogate.
+///
+/// The widest kernels the CPU supports are chosen at runtime on first use.
+namespace QJsonEscape {
+using PlainKernel = qsizetype (*)(const ushort *src, qsizetype n, uchar *dst);
+using TextKernel = qsizetype (*)(const ushort *src, qsizetype n);
+
+inline bool isPlain(ushort u) {
+  return u >= 0x20 && u < 0x80 && u != '"' && u != '\\';
+}
+
+inline bool isText(ushort u) {
+  return u >= 0x80 ? !QChar::isSurrogate(u) : isPlain(u);
+}
+
+inline qsizetype plainRunScalar(const ushort *src, qsizetype n, uchar *dst) {
+  qsizetype i = 0;
+  for (; i < n && isPlain(src[i]); ++i)
+    if (dst)
+      dst[i] = uchar(src[i]);
+  return i;
+}
+
+inline qsizetype textRunScalar(const ushort *src, qsizetype n) {
+  qsizetype i = 0;
+  while (i < n && isText(src[i]))
+    ++i;
+  return i;
+}
+
+#ifdef QJSONESCAPE_SSE2
+/// Bit i is set when byte i of \a bytes is plain. The bytes come from a
+/// saturating pack, so units above 0xff arrive as 0x00 or 0xff and fail the
+/// signed "> 0x1f" test like every other non-ASCII or control unit.
+inline int plainMask(__m128i bytes) {
+  const __m128i printable = _mm_cmpgt_epi8(bytes, _mm_set1_epi8(0x1f));
+  const __m128i special =
+      _mm_or_si128(_mm_cmpeq_epi8(bytes, _mm_set1_epi8('"')),
+                   _mm_cmpeq_epi8(bytes, _mm_set1_epi8('\\')));
+  return _mm_movemask_epi8(_mm_andnot_si128(special, printable));
+}
+
+inline qsizetype plainRunSse2(const ushort *src, qsizetype n, uchar *dst) {
+  qsizetype i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m128i lo =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    const __m128i hi =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i + 8));
+    const __m128i bytes = _mm_packus_epi16(lo, hi);
+    const int mask = plainMask(bytes);
+    if (mask != 0xffff) {
+      const uint plain = qCountTrailingZeroBits(uint(~mask));
+      if (dst) {
+        alignas(16) uchar block[16];
+        _mm_store_si128(reinterpret_cast<__m128i *>(block), bytes);
+        std::memcpy(dst + i, block, plain);
+      }
+      return i + plain;
+    }
+    if (dst)
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), bytes);
+  }
+  return i + plainRunScalar(src + i, n - i, dst ? dst + i : nullptr);
+}
+
+inline qsizetype textRunSse2(const ushort *src, qsizetype n) {
+  qsizetype i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m128i u =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+    const __m128i control = _mm_cmpeq_epi16(
+        _mm_subs_epu16(u, _mm_set1_epi16(0x1f)), _mm_setzero_si128());
+    const __m128i special =
+        _mm_or_si128(_mm_cmpeq_epi16(u, _mm_set1_epi16('"')),
+                     _mm_cmpeq_epi16(u, _mm_set1_epi16('\\')));
+    const __m128i surrogate =
+        _mm_cmpeq_epi16(_mm_and_si128(u, _mm_set1_epi16(-0x800)),
+                        _mm_set1_epi16(-0x2800)); // 0xd800
+    const uint mask = uint(_mm_movemask_epi8(
+        _mm_or_si128(_mm_or_si128(control, special), surrogate)));
+    if (mask) // Two mask bits per unit
+      return i + qCountTrailingZeroBits(mask) / 2;
+  }
+  return i + textRunScalar(src + i, n - i);
+}
+#endif
+
+#ifdef QJSONESCAPE_AVX2
+__attribute__((target("avx2"))) inline qsizetype
+plainRunAvx2(const ushort *src, qsizetype n, uchar *dst) {
+  qsizetype i = 0;
+  for (; i + 32 <= n; i += 32) {
+    const __m256i lo =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+    const __m256i hi =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i + 16));
+    // The pack works per 128-bit lane; put the quadwords back in order
+    const __m256i bytes =
+        _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xd8);
+    const __m256i printable =
+        _mm256_cmpgt_epi8(bytes, _mm256_set1_epi8(0x1f));
+    const __m256i special =
+        _mm256_or_si256(_mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('"')),
+                        _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('\\')));
+    const uint mask =
+        uint(_mm256_movemask_epi8(_mm256_andnot_si256(special, printable)));
+    if (mask != 0xffffffffu) {
+      const uint plain = qCountTrailingZeroBits(~mask);
+      if (dst) {
+        alignas(32) uchar block[32];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(block), bytes);
+        std::memcpy(dst + i, block, plain);
+      }
+      return i + plain;
+    }
+    if (dst)
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), bytes);
+  }
+  return i + plainRunSse2(src + i, n - i, dst ? dst + i : nullptr);
+}
+
+__attribute__((target("avx2"))) inline qsizetype
+textRunAvx2(const ushort *src, qsizetype n) {
+  qsizetype i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m256i u =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+    const __m256i control = _mm256_cmpeq_epi16(
+        _mm256_subs_epu16(u, _mm256_set1_epi16(0x1f)), _mm256_setzero_si256());
+    const __m256i special =
+        _mm256_or_si256(_mm256_cmpeq_epi16(u, _mm256_set1_epi16('"')),
+                        _mm256_cmpeq_epi16(u, _mm256_set1_epi16('\\')));
+    const __m256i surrogate =
+        _mm256_cmpeq_epi16(_mm256_and_si256(u, _mm256_set1_epi16(-0x800)),
+                           _mm256_set1_epi16(-0x2800)); // 0xd800
+    const uint mask = uint(_mm256_movemask_epi8(
+        _mm256_or_si256(_mm256_or_si256(control, special), surrogate)));
+    if (mask)
+      return i + qCountTrailingZeroBits(mask) / 2;
+  }
+  return i + textRunSse2(src + i, n - i);
+}
+#endif
+
+struct Kernels {
+  PlainKernel plainRun;
+  TextKernel textRun;
+};
+
+inline Kernels selectKernels() {
+#ifdef QJSONESCAPE_AVX2
+  if (__builtin_cpu_supports("avx2"))
+    return {plainRunAvx2, textRunAvx2};
+#endif
+#ifdef QJSONESCAPE_SSE2
+  return {plainRunSse2, textRunSse2};
+#else
+  return {plainRunScalar, textRunScalar};
+#endif
+}
+
+inline const Kernels &kernels() {
+  static const Kernels selected = selectKernels();
+  return selected;
+}
+
+inline qsizetype plainRun(const ushort *src, qsizetype n, uchar *dst) {
+  return kernels().plainRun(src, n, dst);
+}
+
+inline qsizetype textRun(const ushort *src, qsizetype n) {
+  return kernels().textRun(src, n);
+}
+} // namespace QJsonEscape
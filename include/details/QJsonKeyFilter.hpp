@@ -0,0 +1,244 @@
+/* QJsonKeyFilter.hpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <array>
+
+/// Exception rules compiled once, then matched against every key of a load.
+///
+/// A rule starting with '/' is a JSON Pointer naming a subtree to skip, e.g.
+/// "/config/credentials". A "*" segment matches any single key or index and
+/// "**" any run of them, the empty one included: "/**/password" skips every
+/// "password" member, "/a/**" skips "a" itself, and "/**" everything below
+/// the root. The root itself is never skipped.
+/// Any other rule is a key pattern: members whose key contains it, ignoring
+/// case, are skipped wherever they are.
+///
+/// Key patterns are folded into one Aho-Corasick automaton: a key is checked
+/// against all of them in a single pass over its characters, with one table
+/// lookup per character.
+class QJsonKeyFilter {
+public:
+  /// Partial matches of the path rules at some node; the rule segments its
+  /// children are compared with. Empty when there are no path rules.
+  struct Position {
+    int rule;
+    int segment;
+    bool operator==(const Position &other) const {
+      return rule == other.rule && segment == other.segment;
+    }
+  };
+  using State = QList<Position>;
+
+  QJsonKeyFilter() = default;
+  explicit QJsonKeyFilter(const QStringList &rules) {
+    QStringList patterns;
+    for (const QString &rule : rules) {
+      if (rule.startsWith('/'))
+        addPath(rule);
+      else if (rule.isEmpty())
+        mMatchAll = true; // Every key contains the empty string
+      else
+        patterns.append(rule.toCaseFolded());
+    }
+    compile(patterns);
+  }
+
+  bool isEmpty() const { return !mMatchAll && !mPatterns && mRules.isEmpty(); }
+  bool hasPathRules() const { return !mRules.isEmpty(); }
+
+  /// True when \a key contains one of the key patterns, ignoring case.
+  bool matches(QStringView key) const {
+    if (mMatchAll)
+      return true;
+    if (!mPatterns)
+      return false;
+
+    int node = 0;
+    for (const QChar c : key) {
+      node = mNext.at(node * mWidth + classOf(c.unicode()));
+      if (mFinal.at(node))
+        return true;
+    }
+    return false;
+  }
+
+  /// State of the document root.
+  State rootState() const {
+    State state;
+    for (int rule = 0; rule < mRules.size(); ++rule)
+      if (enter(state, rule, 0))
+        state.append({rule, int(mRules.at(rule).size())});
+    return state;
+  }
+
+  /// True when the member \a key of a node in state \a parent is excluded.
+  /// Otherwise \a child receives the state of that member.
+  bool skipMember(const State &parent, QStringView key, State &child) const {
+    if (matches(key))
+      return true;
+    return step(parent, key, child);
+  }
+
+  /// As skipMember(), for the element at \a index of an array.
+  bool skipElement(const State &parent, qsizetype index, State &child) const {
+    if (parent.isEmpty()) {
+      child.clear();
+      return false;
+    }
+    return step(parent, QString::number(index), child);
+  }
+
+private:
+  struct Segment {
+    QString key;
+    bool any = false;  // "*"
+    bool many = false; // "**"
+  };
+
+  void addPath(const QString &pointer) {
+    QList<Segment> segments;
+    for (const QString &part : pointer.mid(1).split('/')) {
+      Segment segment;
+      segment.any = part == QLatin1String("*");
+      segment.many = part == QLatin1String("**");
+      // JSON Pointer escapes; "~1" must be decoded first
+      segment.key = QString(part).replace("~1", "/").replace("~0", "~");
+      segments.append(segment);
+    }
+    mRules.append(segments);
+  }
+
+  /// Adds the position at \a segment of \a rule, and the ones a "**" there
+  /// can skip to. Returns true when the rule matched in full.
+  bool enter(State &state, int rule, int segment) const {
+    const QList<Segment> &segments = mRules.at(rule);
+    if (segment == segments.size())
+      return true;
+    if (!state.contains(Position{rule, segment}))
+      state.append({rule, segment});
+    if (segments.at(segment).many)
+      return enter(state, rule, segment + 1);
+    return false;
+  }
+
+  bool step(const State &parent, QStringView key, State &child) const {
+    child.clear();
+    for (const Position &position : parent) {
+      const QList<Segment> &segments = mRules.at(position.rule);
+      // A rule that matched the root in full covers everything below it
+      if (position.segment == segments.size())
+        return true;
+      const Segment &segment = segments.at(position.segment);
+      if (segment.many) {
+        // Consumes the key and stays, so it can consume more; matches in
+        // full when only "**" segments are left
+        if (enter(child, position.rule, position.segment))
+          return true;
+      } else if (segment.any || segment.key == key) {
+        if (enter(child, position.rule, position.segment + 1))
+          return true;
+      }
+    }
+    return false;
+  }
+
+  static char16_t fold(char16_t c) {
+    return char16_t(QChar::toCaseFolded(char32_t(c)));
+  }
+
+  int classOf(char16_t c) const {
+    if (c < 128)
+      return mAscii[c];
+    return mClasses.value(fold(c), 0);
+  }
+
+  void compile(const QStringList &patterns) {
+    mPatterns = int(patterns.size());
+    if (!mPatterns)
+      return;
+
+    // Characters that occur in no pattern all share class 0
+    for (const QString &pattern : patterns)
+      for (const QChar c : pattern)
+        if (!mClasses.contains(c.unicode()))
+          mClasses.insert(c.unicode(), int(mClasses.size()) + 1);
+    mWidth = int(mClasses.size()) + 1;
+    for (char16_t c = 0; c < 128; ++c)
+      mAscii[c] = mClasses.value(fold(c), 0);
+
+    // Trie of the patterns
+    mNext = QList<int>(mWidth, 0);
+    mFinal = QList<bool>(1, false);
+    for (const QString &pattern : patterns) {
+      int node = 0;
+      for (const QChar c : pattern) {
+        const int cls = mClasses.value(c.unicode());
+        if (!mNext.at(node * mWidth + cls)) {
+          mNext[node * mWidth + cls] = int(mFinal.size());
+          mNext.resize(mNext.size() + mWidth, 0);
+          mFinal.append(false);
+        }
+        node = mNext.at(node * mWidth + cls);
+      }
+      mFinal[node] = true;
+    }
+
+    // Breadth-first over the trie: missing transitions take the failure
+    // link's, which turns the trie into a complete automaton
+    QList<int> fail(mFinal.size(), 0);
+    QList<int> queue;
+    for (int cls = 0; cls < mWidth; ++cls)
+      if (const int child = mNext.at(cls))
+        queue.append(child);
+    for (qsizetype i = 0; i < queue.size(); ++i) {
+      const int node = queue.at(i);
+      mFinal[node] = mFinal.at(node) || mFinal.at(fail.at(node));
+      for (int cls = 0; cls < mWidth; ++cls) {
+        int &next = mNext[node * mWidth + cls];
+        const int viaFail = mNext.at(fail.at(node) * mWidth + cls);
+        if (next) {
+          fail[next] = viaFail;
+          queue.append(next);
+        } else {
+          next = viaFail;
+        }
+      }
+    }
+  }
+
+  QList<QList<Segment>> mRules;
+  bool mMatchAll = false;
+  int mPatterns = 0;
+  int mWidth = 1;
+  std::array<int, 128> mAscii{};
+  QHash<char16_t, int> mClasses;
+  QList<int> mNext;
+  QList<bool> mFinal;
+};
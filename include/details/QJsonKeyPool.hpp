@@ -0,0 +1,78 @@
+/* QJsonKeyPool.hpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <QSet>
+#include <QString>
+#include <utility>
+
+/// Pool of object keys seen during a load. Repeated keys come back as
+/// copies of the pooled string, which share its storage instead of each
+/// node holding an allocation of its own. Not thread-safe: concurrent
+/// builders each use their own pool.
+class QJsonKeyPool {
+public:
+  QString intern(QString &&key) {
+    const auto it = mKeys.constFind(key);
+    if (it != mKeys.constEnd()) {
+      mBytesSaved += stringBytes(key.size());
+      return *it;
+    }
+    mKeys.insert(key);
+    return std::move(key);
+  }
+
+  /// Counts the string an array element would have held for \a index,
+  /// which the item now derives from its row instead.
+  void skipIndex(qsizetype index) {
+    qsizetype digits = 1;
+    for (; index >= 10; index /= 10)
+      ++digits;
+    mBytesSaved += stringBytes(digits);
+  }
+
+  /// Adds the savings of another pool, e.g. one used by a worker thread.
+  void addSaved(qint64 bytes) { mBytesSaved += bytes; }
+
+  void clear() {
+    mKeys.clear();
+    mBytesSaved = 0;
+  }
+
+  qsizetype count() const { return mKeys.size(); }
+
+  /// Estimated heap bytes not allocated thanks to the pool.
+  qint64 bytesSaved() const { return mBytesSaved; }
+
+  /// Heap footprint of a QString of \a length characters: the shared data
+  /// header plus the UTF-16 payload and its terminator.
+  static qint64 stringBytes(qsizetype length) {
+    return qint64(sizeof(QArrayData)) + (length + 1) * qint64(sizeof(char16_t));
+  }
+
+private:
+  QSet<QString> mKeys;
+  qint64 mBytesSaved = 0;
+};
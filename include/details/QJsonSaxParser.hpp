@@ -0,0 +1,541 @@
+/* QJsonSaxParser.hpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <QJsonDocument>
+#include <QList>
+#include <QString>
+#include <cstring>
+#include <utility>
+
+#include "QUtf8.hpp"
+
+namespace QJsonSax {
+/// What the parser does with the value following a key.
+enum KeyAction { Accept, Skip, Abort };
+
+inline bool isWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+inline int hexValue(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+} // namespace QJsonSax
+
+/// Event-driven JSON parser reading UTF-8 bytes directly, without building
+/// a QJsonDocument. \a Handler gets one call per token; every call returns
+/// false (or QJsonSax::Abort) to stop the parse:
+///
+///   bool startObject();  bool endObject();
+///   bool startArray();   bool endArray();
+///   QJsonSax::KeyAction key(QString &&key);
+///   QJsonSax::KeyAction element();   // before each array element
+///   bool string(QString &&value);
+///   bool number(const char *text, qsizetype length, bool isInteger);
+///   bool boolean(bool value);
+///   bool null();
+///
+/// A value whose key() or element() was answered with QJsonSax::Skip is
+/// still validated, but no event is sent for it and none of its strings
+/// are decoded.
+template <typename Handler> class QJsonSaxParser {
+public:
+  static constexpr int MaxDepth = 1024;
+
+  QJsonSaxParser(const char *data, qsizetype size, Handler &handler,
+                 int depth = 0)
+      : mBegin(data), mPos(data), mEnd(data + size), mHandler(handler),
+        mDepth(depth) {}
+
+  /// Parses a whole document; the top-level value must be an object or an
+  /// array, as for QJsonDocument.
+  bool parseDocument() {
+    skipWhitespace();
+    if (mPos == mEnd || (*mPos != '{' && *mPos != '['))
+      return fail(QJsonParseError::IllegalValue);
+    if (!parseValue(true))
+      return false;
+    skipWhitespace();
+    if (mPos != mEnd)
+      return fail(QJsonParseError::GarbageAtEnd);
+    return true;
+  }
+
+  /// Parses a comma separated run of array elements, or of object members
+  /// when \a isObject, spanning the whole input. This is how the ranges
+  /// found by QJsonSaxSplit are parsed.
+  bool parseMembers(bool isObject) {
+    while (true) {
+      skipWhitespace();
+      if (!(isObject ? parseMember(true) : parseElement(true)))
+        return false;
+      skipWhitespace();
+      if (mPos == mEnd)
+        return true;
+      if (*mPos != ',')
+        return fail(QJsonParseError::MissingValueSeparator);
+      ++mPos;
+    }
+  }
+
+  QJsonParseError::ParseError error() const { return mError; }
+  /// Byte offset of the error from the start of the input.
+  qsizetype errorOffset() const { return mErrorOffset; }
+  /// True if the handler stopped the parse rather than a syntax error.
+  bool aborted() const { return mAborted; }
+
+private:
+  bool fail(QJsonParseError::ParseError error) {
+    mError = error;
+    mErrorOffset = mPos - mBegin;
+    return false;
+  }
+
+  bool abort() {
+    mAborted = true;
+    return false;
+  }
+
+  void skipWhitespace() {
+    while (mPos < mEnd && QJsonSax::isWhitespace(*mPos))
+      ++mPos;
+  }
+
+  bool parseValue(bool emit) {
+    skipWhitespace();
+    if (mPos == mEnd)
+      return fail(QJsonParseError::IllegalValue);
+
+    switch (*mPos) {
+    case '{':
+      return parseObject(emit);
+    case '[':
+      return parseArray(emit);
+    case '"': {
+      if (!emit)
+        return skipString();
+      QString str;
+      if (!parseString(str))
+        return false;
+      return mHandler.string(std::move(str)) || abort();
+    }
+    case 't':
+      return parseLiteral("true", 4) && (!emit || mHandler.boolean(true) ||
+                                         abort());
+    case 'f':
+      return parseLiteral("false", 5) &&
+             (!emit || mHandler.boolean(false) || abort());
+    case 'n':
+      return parseLiteral("null", 4) && (!emit || mHandler.null() || abort());
+    default:
+      return parseNumber(emit);
+    }
+  }
+
+  bool parseObject(bool emit) {
+    if (++mDepth > MaxDepth)
+      return fail(QJsonParseError::DeepNesting);
+    ++mPos;
+    if (emit && !mHandler.startObject())
+      return abort();
+
+    skipWhitespace();
+    if (mPos < mEnd && *mPos == '}') {
+      ++mPos;
+    } else {
+      while (true) {
+        skipWhitespace();
+        if (!parseMember(emit))
+          return false;
+        skipWhitespace();
+        if (mPos == mEnd)
+          return fail(QJsonParseError::UnterminatedObject);
+        if (*mPos == '}') {
+          ++mPos;
+          break;
+        }
+        if (*mPos != ',')
+          return fail(QJsonParseError::MissingValueSeparator);
+        ++mPos;
+      }
+    }
+
+    --mDepth;
+    return !emit || mHandler.endObject() || abort();
+  }
+
+  bool parseMember(bool emit) {
+    if (mPos == mEnd || *mPos != '"')
+      return fail(QJsonParseError::IllegalValue);
+
+    bool emitValue = emit;
+    if (emit) {
+      QString key;
+      if (!parseString(key))
+        return false;
+      switch (mHandler.key(std::move(key))) {
+      case QJsonSax::Skip:
+        emitValue = false;
+        break;
+      case QJsonSax::Abort:
+        return abort();
+      default:
+        break;
+      }
+    } else if (!skipString()) {
+      return false;
+    }
+
+    skipWhitespace();
+    if (mPos == mEnd || *mPos != ':')
+      return fail(QJsonParseError::MissingNameSeparator);
+    ++mPos;
+    return parseValue(emitValue);
+  }
+
+  bool parseElement(bool emit) {
+    if (!emit)
+      return parseValue(false);
+    switch (mHandler.element()) {
+    case QJsonSax::Skip:
+      return parseValue(false);
+    case QJsonSax::Abort:
+      return abort();
+    default:
+      return parseValue(true);
+    }
+  }
+
+  bool parseArray(bool emit) {
+    if (++mDepth > MaxDepth)
+      return fail(QJsonParseError::DeepNesting);
+    ++mPos;
+    if (emit && !mHandler.startArray())
+      return abort();
+
+    skipWhitespace();
+    if (mPos < mEnd && *mPos == ']') {
+      ++mPos;
+    } else {
+      while (true) {
+        if (!parseElement(emit))
+          return false;
+        skipWhitespace();
+        if (mPos == mEnd)
+          return fail(QJsonParseError::UnterminatedArray);
+        if (*mPos == ']') {
+          ++mPos;
+          break;
+        }
+        if (*mPos != ',')
+          return fail(QJsonParseError::MissingValueSeparator);
+        ++mPos;
+      }
+    }
+
+    --mDepth;
+    return !emit || mHandler.endArray() || abort();
+  }
+
+  bool parseLiteral(const char *literal, int length) {
+    if (mEnd - mPos < length || std::memcmp(mPos, literal, length) != 0)
+      return fail(QJsonParseError::IllegalValue);
+    mPos += length;
+    return true;
+  }
+
+  bool parseNumber(bool emit) {
+    const char *start = mPos;
+    if (*mPos == '-')
+      ++mPos;
+    if (mPos == mEnd || !QJsonSax::isDigit(*mPos))
+      return fail(QJsonParseError::IllegalValue);
+
+    if (*mPos == '0')
+      ++mPos;
+    else
+      while (mPos < mEnd && QJsonSax::isDigit(*mPos))
+        ++mPos;
+
+    bool isInteger = true;
+    if (mPos < mEnd && *mPos == '.') {
+      isInteger = false;
+      if (++mPos == mEnd || !QJsonSax::isDigit(*mPos))
+        return fail(QJsonParseError::IllegalNumber);
+      while (mPos < mEnd && QJsonSax::isDigit(*mPos))
+        ++mPos;
+    }
+    if (mPos < mEnd && (*mPos == 'e' || *mPos == 'E')) {
+      isInteger = false;
+      if (++mPos < mEnd && (*mPos == '+' || *mPos == '-'))
+        ++mPos;
+      if (mPos == mEnd || !QJsonSax::isDigit(*mPos))
+        return fail(QJsonParseError::IllegalNumber);
+      while (mPos < mEnd && QJsonSax::isDigit(*mPos))
+        ++mPos;
+    }
+
+    return !emit || mHandler.number(start, mPos - start, isInteger) ||
+           abort();
+  }
+
+  /// Checks a string nobody wants as strictly as parseString() does:
+  /// escapes, control characters and UTF-8. Nothing is decoded into a
+  /// QString; each unit goes to a scratch buffer and is dropped.
+  bool skipString() {
+    ++mPos;
+    while (mPos < mEnd) {
+      const uchar c = uchar(*mPos++);
+      if (c == '"')
+        return true;
+      ushort scratch[2];
+      ushort *dst = scratch;
+      if (c == '\\') {
+        if (mPos == mEnd)
+          break;
+        if (!parseEscape(dst))
+          return false;
+      } else if (c < 0x20) {
+        --mPos;
+        return fail(QJsonParseError::IllegalValue);
+      } else if (c >= 0x80) {
+        const uchar *src = reinterpret_cast<const uchar *>(mPos);
+        const uchar *end = reinterpret_cast<const uchar *>(mEnd);
+        if (QUtf8Functions::fromUtf8<QUtf8BaseTraits>(c, dst, src, end) < 0) {
+          --mPos;
+          return fail(QJsonParseError::IllegalUTF8String);
+        }
+        mPos = reinterpret_cast<const char *>(src);
+      }
+    }
+    return fail(QJsonParseError::UnterminatedString);
+  }
+
+  bool parseString(QString &out) {
+    const char *start = ++mPos;
+
+    // Plain ASCII is by far the common case and needs no decoding
+    while (mPos < mEnd) {
+      const uchar c = uchar(*mPos);
+      if (c == '"' || c == '\\' || c < 0x20 || c >= 0x80)
+        break;
+      ++mPos;
+    }
+    if (mPos < mEnd && *mPos == '"') {
+      out = QString::fromLatin1(start, mPos - start);
+      ++mPos;
+      return true;
+    }
+
+    // Find the closing quote: the string never needs more UTF-16 units
+    // than it has bytes, so the output is sized once.
+    const char *close = mPos;
+    while (close < mEnd && *close != '"')
+      close += *close == '\\' ? 2 : 1;
+    if (close >= mEnd) {
+      mPos = mEnd;
+      return fail(QJsonParseError::UnterminatedString);
+    }
+
+    out.resize(close - start);
+    ushort *dst = reinterpret_cast<ushort *>(out.data());
+    for (const char *p = start; p < mPos; ++p)
+      *dst++ = uchar(*p);
+
+    while (mPos < close) {
+      const uchar c = uchar(*mPos++);
+      if (c == '\\') {
+        if (!parseEscape(dst))
+          return false;
+      } else if (c < 0x20) {
+        --mPos;
+        return fail(QJsonParseError::IllegalValue);
+      } else if (c < 0x80) {
+        *dst++ = c;
+      } else {
+        const uchar *src = reinterpret_cast<const uchar *>(mPos);
+        const uchar *end = reinterpret_cast<const uchar *>(close);
+        if (QUtf8Functions::fromUtf8<QUtf8BaseTraits>(c, dst, src, end) < 0) {
+          --mPos;
+          return fail(QJsonParseError::IllegalUTF8String);
+        }
+        mPos = reinterpret_cast<const char *>(src);
+      }
+    }
+
+    out.resize(dst - reinterpret_cast<const ushort *>(out.constData()));
+    ++mPos;
+    return true;
+  }
+
+  bool parseEscape(ushort *&dst) {
+    switch (*mPos++) {
+    case '"':
+      *dst++ = '"';
+      break;
+    case '\\':
+      *dst++ = '\\';
+      break;
+    case '/':
+      *dst++ = '/';
+      break;
+    case 'b':
+      *dst++ = '\b';
+      break;
+    case 'f':
+      *dst++ = '\f';
+      break;
+    case 'n':
+      *dst++ = '\n';
+      break;
+    case 'r':
+      *dst++ = '\r';
+      break;
+    case 't':
+      *dst++ = '\t';
+      break;
+    case 'u': {
+      // Surrogate pairs arrive as two escapes and combine in UTF-16
+      if (mEnd - mPos < 4)
+        return fail(QJsonParseError::IllegalEscapeSequence);
+      ushort u = 0;
+      for (int i = 0; i < 4; ++i) {
+        const int h = QJsonSax::hexValue(mPos[i]);
+        if (h < 0)
+          return fail(QJsonParseError::IllegalEscapeSequence);
+        u = ushort(u << 4 | h);
+      }
+      mPos += 4;
+      *dst++ = u;
+      break;
+    }
+    default:
+      --mPos;
+      return fail(QJsonParseError::IllegalEscapeSequence);
+    }
+    return true;
+  }
+
+  const char *mBegin;
+  const char *mPos;
+  const char *mEnd;
+  Handler &mHandler;
+  int mDepth;
+  QJsonParseError::ParseError mError = QJsonParseError::NoError;
+  qsizetype mErrorOffset = 0;
+  bool mAborted = false;
+};
+
+/// Finds the members of a document's top-level container without decoding
+/// anything, so that ranges of members can be parsed concurrently with
+/// QJsonSaxParser::parseMembers(). Only the structure is checked; the
+/// members themselves are validated when parsed.
+struct QJsonSaxSplit {
+  bool isObject = false;
+  /// Byte range of every member, separators and surrounding space excluded
+  QList<qsizetype> begins;
+  QList<qsizetype> ends;
+
+  qsizetype count() const { return begins.size(); }
+
+  bool scan(const char *data, qsizetype size) {
+    const char *p = data;
+    const char *const end = data + size;
+    auto skipWhitespace = [&] {
+      while (p < end && QJsonSax::isWhitespace(*p))
+        ++p;
+    };
+
+    begins.clear();
+    ends.clear();
+    skipWhitespace();
+    if (p == end || (*p != '{' && *p != '['))
+      return false;
+    isObject = *p++ == '{';
+    const char close = isObject ? '}' : ']';
+
+    skipWhitespace();
+    if (p < end && *p == close) {
+      ++p;
+      skipWhitespace();
+      return p == end;
+    }
+
+    int depth = 0;
+    begins.append(p - data);
+    while (p < end) {
+      const char c = *p++;
+      switch (c) {
+      case '"':
+        while (p < end && *p != '"')
+          p += *p == '\\' ? 2 : 1;
+        if (p >= end)
+          return false;
+        ++p;
+        break;
+      case '{':
+      case '[':
+        ++depth;
+        break;
+      case '}':
+      case ']':
+        if (depth-- > 0)
+          break;
+        if (c != close)
+          return false;
+        ends.append(trimmed(data, p - 1 - data));
+        skipWhitespace();
+        return p == end;
+      case ',':
+        if (depth > 0)
+          break;
+        ends.append(trimmed(data, p - 1 - data));
+        skipWhitespace();
+        if (p == end || *p == close)
+          return false;
+        begins.append(p - data);
+        break;
+      default:
+        break;
+      }
+    }
+    return false;
+  }
+
+private:
+  /// Moves \a offset back over the whitespace preceding it.
+  static qsizetype trimmed(const char *data, qsizetype offset) {
+    while (offset > 0 && QJsonSax::isWhitespace(data[offset - 1]))
+      --offset;
+    return offset;
+  }
+};
@@ -0,0 +1,274 @@
+/* QJsonScalar.hpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <QJsonValue>
+#include <QLocale>
+#include <QString>
+#include <QVariant>
+#include <limits>
+#include <new>
+#include <utility>
+
+/// Value of a scalar tree node: a tag and a union of double, integer, bool
+/// and string, instead of a QVariant. Numbers stay numbers without a
+/// string of their own, and the type the document gave them survives a
+/// load and save. Integers too large for qint64 and numbers a double would
+/// round are kept as Number, their text, which writers emit verbatim.
+class QJsonScalar {
+public:
+  enum Kind : quint8 { Undefined, Null, Bool, Integer, Double, Number, String };
+
+  QJsonScalar() : mInteger(0) {}
+  QJsonScalar(std::nullptr_t) : mInteger(0), mKind(Null) {}
+  QJsonScalar(bool value) : mBool(value), mKind(Bool) {}
+  QJsonScalar(qint64 value) : mInteger(value), mKind(Integer) {}
+  QJsonScalar(double value) : mDouble(value), mKind(Double) {}
+  QJsonScalar(QString value, Kind kind = String) : mKind(kind) {
+    Q_ASSERT(kind == String || kind == Number);
+    new (&mString) QString(std::move(value));
+  }
+  // Would otherwise convert to bool
+  QJsonScalar(const char *) = delete;
+  QJsonScalar(const QJsonScalar &other) : mInteger(0) { assign(other); }
+  QJsonScalar(QJsonScalar &&other) noexcept : mInteger(0) {
+    assign(std::move(other));
+  }
+  ~QJsonScalar() { clear(); }
+
+  QJsonScalar &operator=(const QJsonScalar &other) {
+    if (this != &other) {
+      clear();
+      assign(other);
+    }
+    return *this;
+  }
+  QJsonScalar &operator=(QJsonScalar &&other) noexcept {
+    if (this != &other) {
+      clear();
+      assign(std::move(other));
+    }
+    return *this;
+  }
+
+  static QJsonScalar fromVariant(const QVariant &value) {
+    switch (value.typeId()) {
+    case QMetaType::UnknownType:
+      return {};
+    case QMetaType::Nullptr:
+      return nullptr;
+    case QMetaType::Bool:
+      return value.toBool();
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::Long:
+    case QMetaType::LongLong:
+    case QMetaType::Short:
+    case QMetaType::UShort:
+      return qint64(value.toLongLong());
+    case QMetaType::ULong:
+    case QMetaType::ULongLong: {
+      const qulonglong u = value.toULongLong();
+      if (u <= qulonglong(std::numeric_limits<qint64>::max()))
+        return qint64(u);
+      return {QString::number(u), Number};
+    }
+    case QMetaType::Float:
+    case QMetaType::Double:
+      return value.toDouble();
+    default:
+      return value.toString();
+    }
+  }
+
+  static QJsonScalar fromJsonValue(const QJsonValue &value) {
+    switch (value.type()) {
+    case QJsonValue::Null:
+      return nullptr;
+    case QJsonValue::Bool:
+      return value.toBool();
+    case QJsonValue::Double: {
+      // QJsonValue keeps integers that fit exactly; so does toVariant()
+      const QVariant number = value.toVariant();
+      if (QMetaType::LongLong == number.typeId())
+        return qint64(number.toLongLong());
+      return value.toDouble();
+    }
+    case QJsonValue::String:
+      return value.toString();
+    default:
+      return {};
+    }
+  }
+
+  Kind kind() const { return mKind; }
+  bool isNull() const { return mKind == Undefined || mKind == Null; }
+  bool isString() const { return mKind == String; }
+  bool isNumber() const {
+    return mKind == Integer || mKind == Double || mKind == Number;
+  }
+
+  bool toBool() const { return mKind == Bool && mBool; }
+  qint64 toInteger() const {
+    switch (mKind) {
+    case Integer:
+      return mInteger;
+    case Double:
+      return qint64(mDouble);
+    case Number:
+      return mString.toLongLong();
+    default:
+      return 0;
+    }
+  }
+  double toDouble() const {
+    switch (mKind) {
+    case Integer:
+      return double(mInteger);
+    case Double:
+      return mDouble;
+    case Number:
+      return mString.toDouble();
+    default:
+      return 0;
+    }
+  }
+  /// The string of String and Number values, null for the other kinds.
+  const QString &text() const {
+    static const QString none;
+    return mKind == String || mKind == Number ? mString : none;
+  }
+
+  /// Text of the value as QVariant::toString() gives it.
+  QString toString() const {
+    switch (mKind) {
+    case Bool:
+      return mBool ? QStringLiteral("true") : QStringLiteral("false");
+    case Integer:
+      return QString::number(mInteger);
+    case Double:
+      return QString::number(mDouble, 'g', QLocale::FloatingPointShortest);
+    case Number:
+    case String:
+      return mString;
+    default:
+      return {};
+    }
+  }
+
+  QVariant toVariant() const {
+    switch (mKind) {
+    case Null:
+      return QVariant::fromValue(nullptr);
+    case Bool:
+      return mBool;
+    case Integer:
+      return qlonglong(mInteger);
+    case Double:
+      return mDouble;
+    case Number:
+    case String:
+      return mString;
+    default:
+      return {};
+    }
+  }
+
+  /// Number values a double would round lose their extra digits here.
+  QJsonValue toJsonValue() const {
+    switch (mKind) {
+    case Bool:
+      return mBool;
+    case Integer:
+      return mInteger;
+    case Double:
+      return mDouble;
+    case Number:
+      return mString.toDouble();
+    case String:
+      return mString;
+    default:
+      return QJsonValue::Null;
+    }
+  }
+
+  friend bool operator==(const QJsonScalar &a, const QJsonScalar &b) {
+    if (a.mKind != b.mKind)
+      return false;
+    switch (a.mKind) {
+    case Bool:
+      return a.mBool == b.mBool;
+    case Integer:
+      return a.mInteger == b.mInteger;
+    case Double:
+      return a.mDouble == b.mDouble;
+    case Number:
+    case String:
+      return a.mString == b.mString;
+    default:
+      return true;
+    }
+  }
+  friend bool operator!=(const QJsonScalar &a, const QJsonScalar &b) {
+    return !(a == b);
+  }
+
+private:
+  void clear() {
+    if (mKind == String || mKind == Number)
+      mString.~QString();
+    mKind = Undefined;
+  }
+
+  // Only called with the union free: no string is alive
+  template <typename Other> void assign(Other &&other) {
+    switch (other.mKind) {
+    case Bool:
+      mBool = other.mBool;
+      break;
+    case Integer:
+      mInteger = other.mInteger;
+      break;
+    case Double:
+      mDouble = other.mDouble;
+      break;
+    case Number:
+    case String:
+      new (&mString) QString(std::forward<Other>(other).mString);
+      break;
+    default:
+      break;
+    }
+    mKind = other.mKind;
+  }
+
+  union {
+    double mDouble;
+    qint64 mInteger;
+    bool mBool;
+    QString mString;
+  };
+  Kind mKind = Undefined;
+};
@@ -0,0 +1,105 @@
+/* QJsonTrigramIndex.hpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QString>
+
+/// Inverted index from the case-folded trigrams of some texts to the items
+/// holding them. A lookup only narrows the search: the candidates it gives
+/// are a superset of the items containing the pattern, to be verified.
+template <typename T> class QJsonTrigramIndex {
+public:
+  /// Shortest pattern the index can answer for.
+  static constexpr qsizetype MinimumLength = 3;
+
+  /// Indexes \a text as belonging to \a item. Adding new text for an item
+  /// keeps its old trigrams: they only cost a failed verification.
+  void add(T *item, QStringView text) {
+    for (qsizetype i = 0; i + MinimumLength <= text.size(); ++i) {
+      QList<T *> &items = mPostings[trigram(text, i)];
+      // Repeats within one text land next to each other
+      if (items.isEmpty() || items.constLast() != item) {
+        items.append(item);
+        ++mEntries;
+      }
+    }
+  }
+
+  /// Items that may contain \a pattern, without duplicates. Returns false
+  /// when \a pattern is too short to be looked up.
+  bool candidates(QStringView pattern, QList<T *> &items) const {
+    if (pattern.size() < MinimumLength)
+      return false;
+
+    // The rarest trigram of the pattern gives the fewest candidates
+    const QList<T *> *shortest = nullptr;
+    for (qsizetype i = 0; i + MinimumLength <= pattern.size(); ++i) {
+      const auto it = mPostings.constFind(trigram(pattern, i));
+      if (it == mPostings.constEnd()) {
+        items.clear();
+        return true;
+      }
+      if (!shortest || it->size() < shortest->size())
+        shortest = &*it;
+    }
+
+    QSet<T *> seen;
+    seen.reserve(shortest->size());
+    items.clear();
+    for (T *item : *shortest)
+      if (!seen.contains(item)) {
+        seen.insert(item);
+        items.append(item);
+      }
+    return true;
+  }
+
+  void clear() {
+    mPostings.clear();
+    mEntries = 0;
+  }
+
+  bool isEmpty() const { return mPostings.isEmpty(); }
+
+  /// Approximate heap footprint of the postings.
+  qint64 bytes() const {
+    return mEntries * qint64(sizeof(T *)) +
+           mPostings.size() * qint64(sizeof(quint64) + sizeof(QList<T *>));
+  }
+
+private:
+  static quint64 trigram(QStringView text, qsizetype i) {
+    quint64 key = 0;
+    for (qsizetype j = i; j < i + MinimumLength; ++j)
+      key = (key << 16) | text.at(j).toCaseFolded().unicode();
+    return key;
+  }
+
+  QHash<quint64, QList<T *>> mPostings;
+  qint64 mEntries = 0;
+};
@@ -22,7 +22,16 @@
  * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#pragma once
+
 #include <QJsonValue>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                  \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define QUTF8_SSE2
+#include <emmintrin.h>
+#endif
 
 namespace QUtf8Functions {
 /// returns 0 on success; errors can only happen if \a u is a surrogate:
@@ -74,6 +83,194 @@ inline int toUtf8(ushort u, OutputPtr &dst, InputPtr &src, InputPtr end) {
   Traits::appendByte(dst, 0x80 | (u & 0x3f));
   return 0;
 }
+/// Number of UTF-8 bytes for the UTF-16 units [src, end), which must not
+/// contain surrogates.
+inline qsizetype utf8Length(const ushort *src, const ushort *end) {
+  const qsizetype n = end - src;
+  qsizetype length = 3 * n;
+  qsizetype i = 0;
+#ifdef QUTF8_SSE2
+  // Every unit takes three bytes, minus one below U+0800 and one more below
+  // U+0080; the compare masks are -1, so adding them subtracts the savings
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i ones = _mm_set1_epi16(1);
+  while (i + 8 <= n) {
+    // Batches keep the 32-bit lane sums from overflowing
+    __m128i sums = zero;
+    const qsizetype batch = qMin<qsizetype>(n, i + 8 * 65536);
+    for (; i + 8 <= batch; i += 8) {
+      const __m128i u =
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+      const __m128i ascii =
+          _mm_cmpeq_epi16(_mm_and_si128(u, _mm_set1_epi16(-0x80)), zero);
+      const __m128i twoByte =
+          _mm_cmpeq_epi16(_mm_and_si128(u, _mm_set1_epi16(-0x800)), zero);
+      sums = _mm_add_epi32(
+          sums, _mm_madd_epi16(_mm_add_epi16(ascii, twoByte), ones));
+    }
+    alignas(16) qint32 lanes[4];
+    _mm_store_si128(reinterpret_cast<__m128i *>(lanes), sums);
+    length += qsizetype(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+  }
+#endif
+  for (; i < n; ++i)
+    length -= (src[i] < 0x80) + (src[i] < 0x800);
+  return length;
+}
+
+/// Block form of toUtf8(): transcodes units from \a src up to \a end into
+/// \a dst, stopping at the first surrogate, the only kind of unit toUtf8()
+/// can fail on. \a src is left there and \a dst after the bytes written.
+/// \a dst must have room for the UTF-8 of the whole range: bytes after the
+/// final \a dst may be overwritten within it.
+///
+/// Units are taken eight at a time, with the bytes of every lane computed
+/// at once. Blocks of a single width (ASCII, Latin and Cyrillic, CJK) are
+/// also packed in vector registers; mixed ones are packed lane by lane.
+inline void toUtf8Block(const ushort *&src, const ushort *end, uchar *&dst) {
+#ifdef QUTF8_SSE2
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i low6 = _mm_set1_epi16(0x3f);
+  const __m128i continuation = _mm_set1_epi16(0x80);
+  while (end - src >= 8) {
+    const __m128i u = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+    const __m128i top5 = _mm_and_si128(u, _mm_set1_epi16(-0x800));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(top5, _mm_set1_epi16(-0x2800))))
+      break; // A surrogate, 0xd800 to 0xdfff
+    const __m128i isAscii =
+        _mm_cmpeq_epi16(_mm_and_si128(u, _mm_set1_epi16(-0x80)), zero);
+    const __m128i isTwo = _mm_cmpeq_epi16(top5, zero);
+    const int ascii = _mm_movemask_epi8(isAscii);
+    const int twoByte = _mm_movemask_epi8(isTwo);
+
+    if (ascii == 0xffff) {
+      _mm_storel_epi64(reinterpret_cast<__m128i *>(dst),
+                       _mm_packus_epi16(u, u));
+      src += 8;
+      dst += 8;
+      continue;
+    }
+
+    // The last byte of every multi-byte form, and the one before it for
+    // three byte forms
+    const __m128i last = _mm_or_si128(_mm_and_si128(u, low6), continuation);
+    const __m128i middle =
+        _mm_or_si128(_mm_and_si128(_mm_srli_epi16(u, 6), low6), continuation);
+    const __m128i lead2 =
+        _mm_or_si128(_mm_srli_epi16(u, 6), _mm_set1_epi16(0xc0));
+    const __m128i lead3 =
+        _mm_or_si128(_mm_srli_epi16(u, 12), _mm_set1_epi16(0xe0));
+
+    if (twoByte == 0xffff && ascii == 0) {
+      // Lead byte in the low half of each lane, continuation in the high
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst),
+                       _mm_or_si128(lead2, _mm_slli_epi16(last, 8)));
+      src += 8;
+      dst += 16;
+      continue;
+    }
+
+    if (twoByte == 0) {
+      // Three bytes per lane, widened to 32 bits: lead, middle, last, 0
+      const __m128i pairs = _mm_or_si128(lead3, _mm_slli_epi16(middle, 8));
+      const __m128i lo = _mm_unpacklo_epi16(pairs, last);
+      const __m128i hi = _mm_unpackhi_epi16(pairs, last);
+      // Drop the zero byte of each word: six bytes per 64-bit half ...
+      const __m128i word0 = _mm_set1_epi64x(0xffffff);
+      const __m128i word1 = _mm_set1_epi64x(0xffffff000000);
+      const __m128i lo6 = _mm_or_si128(_mm_and_si128(lo, word0),
+                                       _mm_and_si128(_mm_srli_epi64(lo, 8),
+                                                     word1));
+      const __m128i hi6 = _mm_or_si128(_mm_and_si128(hi, word0),
+                                       _mm_and_si128(_mm_srli_epi64(hi, 8),
+                                                     word1));
+      // ... then the upper half moved down against the lower one
+      const __m128i half0 = _mm_set_epi64x(0, -1);
+      const __m128i lo12 =
+          _mm_or_si128(_mm_and_si128(lo6, half0),
+                       _mm_srli_si128(_mm_andnot_si128(half0, lo6), 2));
+      const __m128i hi12 =
+          _mm_or_si128(_mm_and_si128(hi6, half0),
+                       _mm_srli_si128(_mm_andnot_si128(half0, hi6), 2));
+      // The second store overwrites the four spare bytes of the first
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), lo12);
+      _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + 12), hi12);
+      const quint32 tail = quint32(_mm_cvtsi128_si32(_mm_srli_si128(hi12, 8)));
+      std::memcpy(dst + 20, &tail, 4);
+      src += 8;
+      dst += 24;
+      continue;
+    }
+
+    // Mixed widths. Every lane's bytes are stored as one whole word, which
+    // the next lane partly overwrites; the spare bytes of the last land on
+    // the output of the units after the block, so enough of those must
+    // follow.
+    if (twoByte == 0xffff) {
+      // ASCII and two byte forms: one 16-bit word per lane
+      if (end - src < 9)
+        break;
+      const __m128i two = _mm_or_si128(lead2, _mm_slli_epi16(last, 8));
+      alignas(16) quint16 words[8];
+      _mm_store_si128(reinterpret_cast<__m128i *>(words),
+                      _mm_or_si128(_mm_and_si128(isAscii, u),
+                                   _mm_andnot_si128(isAscii, two)));
+      qsizetype size = 0;
+      for (int lane = 0; lane < 8; ++lane) {
+        std::memcpy(dst + size, &words[lane], 2);
+        size += 2 - ((ascii >> (2 * lane)) & 1);
+      }
+      src += 8;
+      dst += size;
+      continue;
+    }
+
+    // Any widths: one 32-bit word per lane
+    if (end - src < 11)
+      break;
+    const __m128i multi = _mm_or_si128(_mm_and_si128(isTwo, lead2),
+                                       _mm_andnot_si128(isTwo, lead3));
+    const __m128i lead = _mm_or_si128(_mm_and_si128(isAscii, u),
+                                      _mm_andnot_si128(isAscii, multi));
+    const __m128i second = _mm_or_si128(_mm_and_si128(isTwo, last),
+                                        _mm_andnot_si128(isTwo, middle));
+    const __m128i pairs = _mm_or_si128(lead, _mm_slli_epi16(second, 8));
+    alignas(16) quint32 words[8];
+    _mm_store_si128(reinterpret_cast<__m128i *>(words),
+                    _mm_unpacklo_epi16(pairs, last));
+    _mm_store_si128(reinterpret_cast<__m128i *>(words + 4),
+                    _mm_unpackhi_epi16(pairs, last));
+    // 3, less one for ASCII and one more below U+0800; one byte per lane
+    const __m128i widths = _mm_add_epi16(_mm_set1_epi16(3),
+                                         _mm_add_epi16(isAscii, isTwo));
+    alignas(16) qint8 lengths[16];
+    _mm_store_si128(reinterpret_cast<__m128i *>(lengths),
+                    _mm_packs_epi16(widths, zero));
+
+    qsizetype size = 0;
+    for (int lane = 0; lane < 8; ++lane) {
+      std::memcpy(dst + size, &words[lane], 4);
+      size += lengths[lane];
+    }
+    src += 8;
+    dst += size;
+  }
+#endif
+  while (src != end && !QChar::isSurrogate(*src)) {
+    const ushort u = *src++;
+    if (u < 0x80) {
+      *dst++ = uchar(u);
+    } else if (u < 0x800) {
+      *dst++ = 0xc0 | uchar(u >> 6);
+      *dst++ = 0x80 | (uchar(u) & 0x3f);
+    } else {
+      *dst++ = 0xe0 | uchar(u >> 12);
+      *dst++ = 0x80 | (uchar(u >> 6) & 0x3f);
+      *dst++ = 0x80 | (uchar(u) & 0x3f);
+    }
+  }
+}
+
 inline bool isContinuationByte(uchar b) { return (b & 0xc0) == 0x80; }
 /// returns the number of characters consumed (including \a b) in case of
 /// success; returns negative in case of error: Traits::Error or
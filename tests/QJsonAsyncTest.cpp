@@ -0,0 +1,204 @@
+/* QJsonAsyncTest.cpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "QJsonModel.hpp"
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace {
+// An array of \a count records of three nodes each
+QByteArray records(int count) {
+  QByteArray json = "[";
+  for (int i = 0; i < count; ++i) {
+    const QByteArray n = QByteArray::number(i);
+    json += QByteArray(i ? "," : "") + R"({"id":)" + n +
+            R"(,"name":"record-)" + n + R"("})";
+  }
+  return json + ']';
+}
+
+bool writeFile(const QString &fileName, const QByteArray &data) {
+  QFile file(fileName);
+  return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+}
+
+struct Progress {
+  qint64 bytesRead;
+  qint64 bytesTotal;
+  qint64 nodes;
+};
+} // namespace
+
+class QJsonAsyncTest : public QObject {
+  Q_OBJECT
+
+private:
+  QTemporaryDir mDir;
+  QString mLarge;
+  QString mSmall;
+  QString mBroken;
+  QByteArray mLargeJson;
+
+private slots:
+  void initTestCase() {
+    QVERIFY(mDir.isValid());
+    // Several read chunks of 1 MiB, and many progress intervals of nodes
+    mLargeJson = records(100000);
+    QVERIFY(mLargeJson.size() > 3 * 1024 * 1024);
+    mLarge = mDir.filePath(QStringLiteral("large.json"));
+    mSmall = mDir.filePath(QStringLiteral("small.json"));
+    mBroken = mDir.filePath(QStringLiteral("broken.json"));
+    QVERIFY(writeFile(mLarge, mLargeJson));
+    QVERIFY(writeFile(mSmall, R"({"small":[1,2,3]})"));
+    QVERIFY(writeFile(mBroken, R"({"broken":[1,2,)"));
+  }
+
+  void progress() {
+    QJsonModel model;
+    // Emitted from the worker: collected on this thread, in order, before
+    // the queued loadFinished()
+    QList<Progress> steps;
+    connect(&model, &QJsonModel::loadProgress, this,
+            [&](qint64 bytesRead, qint64 bytesTotal, qint64 nodes) {
+              steps.append({bytesRead, bytesTotal, nodes});
+            });
+    QSignalSpy finished(&model, &QJsonModel::loadFinished);
+
+    QVERIFY(model.loadAsync(mLarge));
+    QVERIFY(model.isLoading());
+    QVERIFY(finished.wait(30000));
+    QCOMPARE(finished.first().first().toBool(), true);
+    QVERIFY(!model.isLoading());
+
+    // Bytes while reading, then nodes while building. Threads building
+    // parts of the array report in no set order, but the last report is
+    // the whole tree.
+    const qint64 total = mLargeJson.size();
+    const qint64 nodes = 3 * 100000 + 1;
+    QVERIFY(steps.size() > 4);
+    qsizetype reading = 0;
+    while (reading < steps.size() && steps.at(reading).nodes == 0)
+      ++reading;
+    QVERIFY(reading >= 3);
+    QVERIFY(reading < steps.size() - 1);
+    for (qsizetype i = 0; i < steps.size(); ++i) {
+      QCOMPARE(steps.at(i).bytesTotal, total);
+      QVERIFY(steps.at(i).bytesRead > 0);
+      QVERIFY(steps.at(i).bytesRead <= total);
+      QVERIFY(steps.at(i).nodes <= nodes);
+      if (i > 0)
+        QVERIFY(steps.at(i).bytesRead >= steps.at(i - 1).bytesRead);
+      if (i >= reading)
+        QCOMPARE(steps.at(i).bytesRead, total);
+    }
+    QCOMPARE(steps.at(reading - 1).bytesRead, total);
+    QCOMPARE(steps.last().nodes, nodes);
+  }
+
+  void singleReset() {
+    QJsonModel model;
+    QVERIFY(model.loadJson(R"({"old":true})"));
+    QSignalSpy aboutToReset(&model, &QJsonModel::modelAboutToBeReset);
+    QSignalSpy resets(&model, &QJsonModel::modelReset);
+    QSignalSpy inserted(&model, &QJsonModel::rowsInserted);
+    QSignalSpy finished(&model, &QJsonModel::loadFinished);
+
+    QVERIFY(model.loadAsync(mLarge));
+    // The old tree stays in place while the worker runs
+    QCOMPARE(model.json(true), QByteArray(R"({"old":true})"));
+    QVERIFY(finished.wait(30000));
+    QCOMPARE(finished.count(), 1);
+    QCOMPARE(finished.first().first().toBool(), true);
+    QCOMPARE(aboutToReset.count(), 1);
+    QCOMPARE(resets.count(), 1);
+    QCOMPARE(inserted.count(), 0);
+    QCOMPARE(model.rowCount(), 100000);
+    QCOMPARE(model.json(true), QJsonModel(mLargeJson).json(true));
+  }
+
+  void cancel() {
+    QJsonModel model;
+    QVERIFY(model.loadJson(R"({"old":true})"));
+    QSignalSpy resets(&model, &QJsonModel::modelReset);
+    QSignalSpy finished(&model, &QJsonModel::loadFinished);
+
+    QVERIFY(model.loadAsync(mLarge));
+    model.cancelLoad();
+    QVERIFY(finished.wait(30000));
+    QCOMPARE(finished.count(), 1);
+    QCOMPARE(finished.first().first().toBool(), false);
+    QVERIFY(!model.isLoading());
+    QCOMPARE(resets.count(), 0);
+    QCOMPARE(model.json(true), QByteArray(R"({"old":true})"));
+  }
+
+  void supersede() {
+    QJsonModel model;
+    QSignalSpy resets(&model, &QJsonModel::modelReset);
+    QSignalSpy finished(&model, &QJsonModel::loadFinished);
+
+    // The first load is cancelled and dropped without a word
+    QVERIFY(model.loadAsync(mLarge));
+    QVERIFY(model.loadAsync(mSmall));
+    QVERIFY(finished.wait(30000));
+    QTest::qWait(100);
+    QCOMPARE(finished.count(), 1);
+    QCOMPARE(finished.first().first().toBool(), true);
+    QCOMPARE(resets.count(), 1);
+    QCOMPARE(model.json(true), QByteArray(R"({"small":[1,2,3]})"));
+  }
+
+  void failure() {
+    QJsonModel model;
+    QVERIFY(model.loadJson(R"({"old":true})"));
+    QSignalSpy resets(&model, &QJsonModel::modelReset);
+    QSignalSpy finished(&model, &QJsonModel::loadFinished);
+
+    QVERIFY(model.loadAsync(mBroken));
+    QVERIFY(finished.wait(30000));
+    QCOMPARE(finished.first().first().toBool(), false);
+    QVERIFY(model.parseError().error != QJsonParseError::NoError);
+    QCOMPARE(resets.count(), 0);
+    QCOMPARE(model.json(true), QByteArray(R"({"old":true})"));
+
+    // A missing file fails right away, without a signal
+    QVERIFY(!model.loadAsync(mDir.filePath(QStringLiteral("missing.json"))));
+    QVERIFY(!model.isLoading());
+    QTest::qWait(50);
+    QCOMPARE(finished.count(), 1);
+  }
+
+  void deletedWhileLoading() {
+    // The worker is stopped and joined before the model goes away
+    auto *model = new QJsonModel;
+    QVERIFY(model->loadAsync(mLarge));
+    delete model;
+  }
+};
+
+QTEST_GUILESS_MAIN(QJsonAsyncTest)
+
+#include "QJsonAsyncTest.moc"
@@ -0,0 +1,187 @@
+/* QJsonBatchTest.cpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "QJsonModel.hpp"
+#include <QSignalSpy>
+#include <QTest>
+
+namespace {
+const QByteArray numbers = "[0,1,2,3,4,5,6,7,8,9]";
+
+// Value cell of \a row under \a parent
+QModelIndex value(const QJsonModel &model, int row,
+                  const QModelIndex &parent = QModelIndex()) {
+  return model.index(row, 1, parent);
+}
+
+// Checks that the dataChanged() recorded at \a signal spans value cells
+// \a top to \a bottom under \a parent
+bool spans(const QSignalSpy &spy, int signal, int top, int bottom,
+           const QModelIndex &parent = QModelIndex()) {
+  const QList<QVariant> &arguments = spy.at(signal);
+  const auto topLeft = arguments.at(0).value<QModelIndex>();
+  const auto bottomRight = arguments.at(1).value<QModelIndex>();
+  return topLeft.row() == top && topLeft.column() == 1 &&
+         bottomRight.row() == bottom && bottomRight.column() == 1 &&
+         topLeft.parent() == parent && bottomRight.parent() == parent &&
+         arguments.at(2).value<QList<int>>() == QList<int>{Qt::EditRole};
+}
+} // namespace
+
+class QJsonBatchTest : public QObject {
+  Q_OBJECT
+
+private slots:
+  void setDataBatch() {
+    QJsonModel model;
+    QVERIFY(model.loadJson(numbers));
+    QSignalSpy changed(&model, &QJsonModel::dataChanged);
+
+    QList<QPair<QModelIndex, QVariant>> edits;
+    for (int row = 2; row <= 5; ++row)
+      edits.append({value(model, row), row * 10});
+    QVERIFY(model.setDataBatch(edits));
+
+    QCOMPARE(changed.count(), 1);
+    QVERIFY(spans(changed, 0, 2, 5));
+    QCOMPARE(model.json(true), QByteArray("[0,1,20,30,40,50,6,7,8,9]"));
+  }
+
+  void beginAndCommit() {
+    QJsonModel model;
+    QVERIFY(model.loadJson(numbers));
+    QSignalSpy changed(&model, &QJsonModel::dataChanged);
+
+    // Out of order and repeated rows still make a single run
+    model.beginBatch();
+    for (int row : {7, 4, 6, 5, 6})
+      QVERIFY(model.setData(value(model, row), -row));
+    QCOMPARE(changed.count(), 0);
+    model.commitBatch();
+
+    QCOMPARE(changed.count(), 1);
+    QVERIFY(spans(changed, 0, 4, 7));
+    QCOMPARE(model.json(true), QByteArray("[0,1,2,3,-4,-5,-6,-7,8,9]"));
+
+    // Nothing left to report
+    model.beginBatch();
+    model.commitBatch();
+    QCOMPARE(changed.count(), 1);
+  }
+
+  void runs() {
+    QJsonModel model;
+    QVERIFY(model.loadJson(numbers));
+    QSignalSpy changed(&model, &QJsonModel::dataChanged);
+
+    model.beginBatch();
+    for (int row : {9, 1, 2, 5})
+      QVERIFY(model.setData(value(model, row), 0));
+    model.commitBatch();
+
+    QCOMPARE(changed.count(), 3);
+    QVERIFY(spans(changed, 0, 1, 2));
+    QVERIFY(spans(changed, 1, 5, 5));
+    QVERIFY(spans(changed, 2, 9, 9));
+  }
+
+  void parents() {
+    QJsonModel model;
+    QVERIFY(model.loadJson(R"({"a":[0,1,2],"b":[0,1,2]})"));
+    const QModelIndex a = model.index(0, 0);
+    const QModelIndex b = model.index(1, 0);
+    QSignalSpy changed(&model, &QJsonModel::dataChanged);
+
+    QVERIFY(model.setDataBatch({{value(model, 0, a), 5},
+                                {value(model, 1, b), 5},
+                                {value(model, 1, a), 5},
+                                {value(model, 2, b), 5}}));
+
+    // One run per parent, in no particular order
+    QCOMPARE(changed.count(), 2);
+    const bool aFirst =
+        changed.at(0).at(0).value<QModelIndex>().parent() == a;
+    QVERIFY(spans(changed, aFirst ? 0 : 1, 0, 1, a));
+    QVERIFY(spans(changed, aFirst ? 1 : 0, 1, 2, b));
+  }
+
+  void nested() {
+    QJsonModel model;
+    QVERIFY(model.loadJson(numbers));
+    QSignalSpy changed(&model, &QJsonModel::dataChanged);
+
+    model.beginBatch();
+    QVERIFY(model.setData(value(model, 3), 0));
+    QVERIFY(model.setDataBatch({{value(model, 4), 0}}));
+    QCOMPARE(changed.count(), 0);
+    model.commitBatch();
+
+    QCOMPARE(changed.count(), 1);
+    QVERIFY(spans(changed, 0, 3, 4));
+
+    // An unmatched commit emits nothing
+    model.commitBatch();
+    QCOMPARE(changed.count(), 1);
+  }
+
+  void refusedEdit() {
+    QJsonModel model;
+    QVERIFY(model.loadJson(numbers));
+    QSignalSpy changed(&model, &QJsonModel::dataChanged);
+
+    // A number cell refuses text that is not a number
+    QVERIFY(!model.setDataBatch({{value(model, 0), QStringLiteral("x")},
+                                 {value(model, 1), 11},
+                                 {value(model, 2), 12}}));
+    QCOMPARE(changed.count(), 1);
+    QVERIFY(spans(changed, 0, 1, 2));
+    QCOMPARE(model.json(true), QByteArray("[0,11,12,3,4,5,6,7,8,9]"));
+  }
+
+  void flushedBeforeRemoval() {
+    QJsonModel model;
+    QVERIFY(model.loadJson(numbers));
+    QSignalSpy changed(&model, &QJsonModel::dataChanged);
+    QSignalSpy removed(&model, &QJsonModel::rowsAboutToBeRemoved);
+
+    // The pending edit is reported while its row still exists
+    model.beginBatch();
+    QVERIFY(model.setData(value(model, 5), 0));
+    qsizetype changedFirst = -1;
+    connect(&model, &QJsonModel::rowsAboutToBeRemoved, this,
+            [&] { changedFirst = changed.count(); });
+    QVERIFY(model.removeRows(4, 2, QModelIndex()));
+    QCOMPARE(removed.count(), 1);
+    QCOMPARE(changedFirst, qsizetype(1));
+    QCOMPARE(changed.count(), 1);
+    QVERIFY(spans(changed, 0, 5, 5));
+
+    model.commitBatch();
+    QCOMPARE(changed.count(), 1);
+  }
+};
+
+QTEST_GUILESS_MAIN(QJsonBatchTest)
+
+#include "QJsonBatchTest.moc"
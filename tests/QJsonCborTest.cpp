@@ -0,0 +1,192 @@
+/* QJsonCborTest.cpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "QJsonModel.hpp"
+#include <QBuffer>
+#include <QCborStreamWriter>
+#include <QTest>
+
+class QJsonCborTest : public QObject {
+  Q_OBJECT
+
+private slots:
+  // JSON, to CBOR, to a tree again: the same output, byte for byte
+  void roundTrip_data() {
+    QTest::addColumn<QByteArray>("json");
+    QTest::newRow("empty object") << QByteArray("{}");
+    QTest::newRow("empty array") << QByteArray("[]");
+    QTest::newRow("scalars")
+        << QByteArray(R"([null,true,false,0,-1,2.5,-0.125,1e300,"","s"])");
+    QTest::newRow("strings")
+        << QByteArray(R"({"esc\"aped":"tab\tline\n","cjk":"服务器",)"
+                      R"("emoji":"😀"})");
+    QTest::newRow("nested")
+        << QByteArray(R"({"a":[1,[2,{"b":[{"c":null}]}]],"d":{"e":{}}})");
+    QTest::newRow("integer limits")
+        << QByteArray("[9223372036854775807,-9223372036854775808,"
+                      "9223372036854775808,18446744073709551615,"
+                      "-9223372036854775809,-18446744073709551616]");
+  }
+  void roundTrip() {
+    QFETCH(QByteArray, json);
+    QJsonModel model;
+    QVERIFY(model.loadJson(json));
+    const QByteArray cbor = model.cbor();
+    QVERIFY(!cbor.isEmpty());
+
+    QJsonModel copy;
+    QVERIFY(copy.loadCbor(cbor));
+    QCOMPARE(copy.json(true), model.json(true));
+    QCOMPARE(copy.cbor(), cbor);
+  }
+
+  // Integers beyond qint64 keep their exact digits, and are written back
+  // as the same CBOR integers
+  void bigIntegers() {
+    QByteArray cbor;
+    {
+      QCborStreamWriter writer(&cbor);
+      writer.startArray(6);
+      writer.append(std::numeric_limits<quint64>::max());
+      writer.append(QCborNegativeInteger(0)); // -2^64
+      writer.append(QCborNegativeInteger(quint64(1) << 63));
+      writer.append(QCborNegativeInteger((quint64(1) << 63) + 1));
+      writer.append(std::numeric_limits<qint64>::max());
+      writer.append(quint64(1) << 63);
+      writer.endArray();
+    }
+    const QStringList expected = {
+        "18446744073709551615", "-18446744073709551616",
+        "-9223372036854775808", "-9223372036854775809",
+        "9223372036854775807",  "9223372036854775808"};
+
+    QJsonModel model;
+    QVERIFY(model.loadCbor(cbor));
+    QCOMPARE(model.rowCount(), int(expected.size()));
+    for (int row = 0; row < model.rowCount(); ++row)
+      QCOMPARE(model.data(model.index(row, 1), Qt::DisplayRole).toString(),
+               expected.at(row));
+    QCOMPARE(model.json(true),
+             '[' + expected.join(u',').toLatin1() + ']');
+    QCOMPARE(model.cbor(), cbor);
+  }
+
+  // CBOR types JSON lacks: byte strings, tags, simple values and keys that
+  // are not text
+  void mappedTypes() {
+    const QByteArray bytes("\x00\xff\xfe", 3);
+    QByteArray cbor;
+    {
+      QCborStreamWriter writer(&cbor);
+      writer.startMap();
+      writer.append(QLatin1String("raw"));
+      writer.append(bytes);
+      writer.append(QLatin1String("base64"));
+      writer.append(QCborKnownTags::ExpectedBase64);
+      writer.append(bytes);
+      writer.append(QLatin1String("hex"));
+      writer.append(QCborKnownTags::ExpectedBase16);
+      writer.append(bytes);
+      writer.append(QLatin1String("epoch"));
+      writer.append(QCborKnownTags::UnixTime_t);
+      writer.append(qint64(1700000000));
+      writer.append(QLatin1String("nested tags"));
+      writer.append(QCborTag(1000));
+      writer.append(QCborTag(1001));
+      writer.append(QLatin1String("text"));
+      writer.append(QLatin1String("undefined"));
+      writer.append(QCborSimpleType::Undefined);
+      writer.append(QLatin1String("simple"));
+      writer.append(QCborSimpleType(32));
+      writer.append(qint64(7));
+      writer.append(QLatin1String("integer key"));
+      writer.append(qint64(-3));
+      writer.append(QLatin1String("negative key"));
+      writer.append(QLatin1String("half"));
+      writer.append(qfloat16(1.5));
+      writer.endMap();
+    }
+    const QJsonObject expected{
+        {"raw", "AP_-"},
+        {"base64", "AP/+"},
+        {"hex", "00fffe"},
+        {"epoch", 1700000000},
+        {"nested tags", "text"},
+        {"undefined", QJsonValue::Null},
+        {"simple", "simple(32)"},
+        {"7", "integer key"},
+        {"-3", "negative key"},
+        {"half", 1.5},
+    };
+
+    QJsonModel model;
+    QVERIFY(model.loadCbor(cbor));
+    QCOMPARE(QJsonDocument::fromJson(model.json()).object(), expected);
+  }
+
+  // Broken CBOR, or CBOR JSON has no document for, is refused and the
+  // tree stays as it was
+  void invalid_data() {
+    QTest::addColumn<QByteArray>("cbor");
+    QByteArray valid;
+    {
+      QCborStreamWriter writer(&valid);
+      writer.startArray(2);
+      writer.append(QLatin1String("a"));
+      writer.append(qint64(1));
+      writer.endArray();
+    }
+    QTest::newRow("empty") << QByteArray();
+    QTest::newRow("truncated") << valid.chopped(1);
+    QTest::newRow("garbage after") << valid + '\x01';
+    QTest::newRow("top-level scalar") << QByteArray("\x01", 1);
+    QTest::newRow("top-level string") << QByteArray("\x61" "a", 2);
+    QTest::newRow("reserved type") << QByteArray("\x81\x1c", 2);
+  }
+  void invalid() {
+    QFETCH(QByteArray, cbor);
+    QJsonModel model;
+    QVERIFY(model.loadJson("[\"kept\"]"));
+    const QByteArray before = model.json(true);
+    QVERIFY(!model.loadCbor(cbor));
+    QCOMPARE(model.json(true), before);
+  }
+
+  void device() {
+    QJsonModel model;
+    QVERIFY(model.loadJson(R"({"a":[1,"two",3.5],"b":{"c":null}})"));
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::ReadWrite));
+    QVERIFY(model.save(&buffer, QJsonModel::Format::Cbor));
+    QCOMPARE(buffer.data(), model.cbor());
+
+    QVERIFY(buffer.seek(0));
+    QJsonModel copy;
+    QVERIFY(copy.load(&buffer, QJsonModel::Format::Cbor));
+    QCOMPARE(copy.json(true), model.json(true));
+  }
+};
+
+QTEST_GUILESS_MAIN(QJsonCborTest)
+#include "QJsonCborTest.moc"
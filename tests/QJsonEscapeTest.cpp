@@ -0,0 +1,258 @@
+/* QJsonEscapeTest.cpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "details/QJsonEscape.hpp"
+#include <QRandomGenerator>
+#include <QTest>
+#include <iterator>
+
+// Defined in QJsonModel.cpp, outside the public API
+void appendEscaped(QByteArray &out, const QString &s);
+
+namespace {
+// One unit of a random class: printable ASCII, escaped ASCII, Latin,
+// CJK or a surrogate half. Biased towards ASCII so plain runs get long.
+ushort randomUnit(QRandomGenerator &random) {
+  static const ushort escaped[] = {'"', '\\', 0x0, 0x8, 0x9, 0xa, 0x1f};
+  switch (random.bounded(16)) {
+  case 0:
+    return escaped[random.bounded(int(std::size(escaped)))];
+  case 1:
+    return ushort(0x80 + random.bounded(0x780));
+  case 2:
+    return ushort(0x4e00 + random.bounded(0x5200));
+  case 3:
+    return ushort(0xd800 + random.bounded(0x800));
+  case 4:
+    return 0x7f;
+  default:
+    return ushort(0x20 + random.bounded(0x5f));
+  }
+}
+
+QList<ushort> randomUnits(QRandomGenerator &random, qsizetype n) {
+  QList<ushort> units(n);
+  for (ushort &u : units)
+    u = randomUnit(random);
+  return units;
+}
+
+struct PlainKernel {
+  const char *name;
+  QJsonEscape::PlainKernel run;
+};
+
+struct TextKernel {
+  const char *name;
+  QJsonEscape::TextKernel run;
+};
+
+QList<PlainKernel> plainKernels() {
+  QList<PlainKernel> kernels;
+#ifdef QJSONESCAPE_SSE2
+  kernels.append({"sse2", QJsonEscape::plainRunSse2});
+#endif
+#ifdef QJSONESCAPE_AVX2
+  if (__builtin_cpu_supports("avx2"))
+    kernels.append({"avx2", QJsonEscape::plainRunAvx2});
+#endif
+  kernels.append({"dispatch", QJsonEscape::plainRun});
+  return kernels;
+}
+
+QList<TextKernel> textKernels() {
+  QList<TextKernel> kernels;
+#ifdef QJSONESCAPE_SSE2
+  kernels.append({"sse2", QJsonEscape::textRunSse2});
+#endif
+#ifdef QJSONESCAPE_AVX2
+  if (__builtin_cpu_supports("avx2"))
+    kernels.append({"avx2", QJsonEscape::textRunAvx2});
+#endif
+  kernels.append({"dispatch", QJsonEscape::textRun});
+  return kernels;
+}
+
+// A run of \a length plain units, then one \a stop unit, then more plain
+// units the kernels must not count
+QList<ushort> runThenStop(qsizetype length, ushort stop) {
+  QList<ushort> units(length + 40, ushort('a'));
+  units[length] = stop;
+  return units;
+}
+
+char hexDigit(uint u) { return "0123456789abcdef"[u & 0xf]; }
+
+// JSON escaping by definition, one code point at a time
+QByteArray referenceEscape(const QString &s) {
+  QByteArray out;
+  for (qsizetype i = 0; i < s.size(); ++i) {
+    const char16_t u = s.at(i).unicode();
+    const char *escape = nullptr;
+    switch (u) {
+    case '"':
+      escape = "\\\"";
+      break;
+    case '\\':
+      escape = "\\\\";
+      break;
+    case '\b':
+      escape = "\\b";
+      break;
+    case '\f':
+      escape = "\\f";
+      break;
+    case '\n':
+      escape = "\\n";
+      break;
+    case '\r':
+      escape = "\\r";
+      break;
+    case '\t':
+      escape = "\\t";
+      break;
+    default:
+      break;
+    }
+    if (escape) {
+      out += escape;
+    } else if (QChar::isHighSurrogate(u) && i + 1 < s.size() &&
+               s.at(i + 1).isLowSurrogate()) {
+      out += s.mid(i, 2).toUtf8();
+      ++i;
+    } else if (u < 0x20 || QChar::isSurrogate(u)) {
+      out += "\\u";
+      for (int shift = 12; shift >= 0; shift -= 4)
+        out += hexDigit(u >> shift);
+    } else {
+      out += QString(QChar(u)).toUtf8();
+    }
+  }
+  return out;
+}
+} // namespace
+
+class QJsonEscapeTest : public QObject {
+  Q_OBJECT
+
+private slots:
+  // Every length across the vector widths, every stop unit class, and
+  // every alignment of the start
+  void plainRun() {
+    const ushort stops[] = {'"', '\\', 0x1f, 0x7f, 0x80, 0xff, 0x100, 0xd800};
+    for (const PlainKernel &kernel : plainKernels()) {
+      for (ushort stop : stops) {
+        for (qsizetype length = 0; length < 80; ++length) {
+          const QList<ushort> units = runThenStop(length, stop);
+          for (qsizetype offset = 0; offset < 4; ++offset) {
+            const qsizetype n = units.size() - offset;
+            const ushort *src = units.constData() + offset;
+            const qsizetype expected =
+                QJsonEscape::plainRunScalar(src, n, nullptr);
+            QByteArray narrowed(n, '\0');
+            uchar *dst = reinterpret_cast<uchar *>(narrowed.data());
+            const qsizetype run = kernel.run(src, n, dst);
+            QVERIFY2(run == expected, kernel.name);
+            for (qsizetype i = 0; i < run; ++i)
+              QCOMPARE(narrowed.at(i), char(src[i]));
+            QCOMPARE(kernel.run(src, n, nullptr), expected);
+          }
+        }
+      }
+    }
+  }
+
+  void textRun() {
+    const ushort stops[] = {'"', '\\', 0x0, 0x1f, 0xd800, 0xdbff, 0xdc00,
+                            0xdfff};
+    for (const TextKernel &kernel : textKernels()) {
+      for (ushort stop : stops) {
+        for (qsizetype length = 0; length < 80; ++length) {
+          QList<ushort> units = runThenStop(length, stop);
+          // Text runs cross non-ASCII units; put some in
+          for (qsizetype i = 1; i < length; i += 3)
+            units[i] = i % 2 ? 0x4e2d : 0xe9;
+          for (qsizetype offset = 0; offset < 4; ++offset) {
+            const qsizetype n = units.size() - offset;
+            const ushort *src = units.constData() + offset;
+            const qsizetype expected = QJsonEscape::textRunScalar(src, n);
+            QVERIFY2(kernel.run(src, n) == expected, kernel.name);
+          }
+        }
+      }
+    }
+  }
+
+  void randomRuns() {
+    QRandomGenerator random(16);
+    for (int round = 0; round < 2000; ++round) {
+      const QList<ushort> units = randomUnits(random, random.bounded(100));
+      for (qsizetype start = 0; start < units.size(); ++start) {
+        const ushort *src = units.constData() + start;
+        const qsizetype n = units.size() - start;
+        const qsizetype plain = QJsonEscape::plainRunScalar(src, n, nullptr);
+        const qsizetype text = QJsonEscape::textRunScalar(src, n);
+        for (const PlainKernel &kernel : plainKernels())
+          QVERIFY2(kernel.run(src, n, nullptr) == plain, kernel.name);
+        for (const TextKernel &kernel : textKernels())
+          QVERIFY2(kernel.run(src, n) == text, kernel.name);
+      }
+    }
+  }
+
+  void appendEscaped_data() {
+    QTest::addColumn<QString>("text");
+    QTest::newRow("empty") << QString();
+    QTest::newRow("plain") << QStringLiteral("plain ascii text, no escapes");
+    QTest::newRow("escapes") << QStringLiteral("\"q\" \\ \b\f\n\r\t \x01\x1f");
+    QTest::newRow("non-ascii")
+        << QString::fromUtf16(u"café naïve Привет 服务器日志记录完成");
+    QTest::newRow("pair") << QString::fromUtf16(u"a😀b😀😀");
+    QTest::newRow("lone high") << QString(QChar(0xd83d)) + u'x';
+    QTest::newRow("lone low") << QStringLiteral("x") + QChar(0xde00);
+    QTest::newRow("high at end") << QStringLiteral("end") + QChar(0xd83d);
+    QTest::newRow("two highs")
+        << QString(QChar(0xd83d)) + QChar(0xd83d) + QChar(0xde00);
+    QTest::newRow("long plain") << QString(1000, u'x');
+    QTest::newRow("long cjk") << QString(1000, QChar(0x65e5));
+
+    QRandomGenerator random(17);
+    for (int i = 0; i < 200; ++i) {
+      const QList<ushort> units = randomUnits(random, random.bounded(300));
+      QTest::newRow(qPrintable(QStringLiteral("random %1").arg(i)))
+          << QString::fromUtf16(reinterpret_cast<const char16_t *>(
+                                    units.constData()),
+                                units.size());
+    }
+  }
+  void appendEscaped() {
+    QFETCH(QString, text);
+    QByteArray out = "prefix";
+    ::appendEscaped(out, text);
+    QCOMPARE(out, "prefix" + referenceEscape(text));
+  }
+};
+
+QTEST_GUILESS_MAIN(QJsonEscapeTest)
+#include "QJsonEscapeTest.moc"
@@ -0,0 +1,118 @@
+/* QJsonFilterTest.cpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "QJsonModel.hpp"
+#include <QTest>
+
+namespace {
+QJsonDocument filtered(const QStringList &rules, const QByteArray &json,
+                       bool lazy = false) {
+  QJsonModel model;
+  model.addException(rules);
+  model.setLazyLoading(lazy);
+  if (!model.loadJson(json))
+    return {};
+  return QJsonDocument::fromJson(model.json());
+}
+
+// Children of \a parent, fetching them all first
+QStringList keys(QJsonModel &model, const QModelIndex &parent) {
+  while (model.canFetchMore(parent))
+    model.fetchMore(parent);
+  QStringList keys;
+  for (int row = 0; row < model.rowCount(parent); ++row)
+    keys.append(model.index(row, 0, parent).data().toString());
+  return keys;
+}
+} // namespace
+
+class QJsonFilterTest : public QObject {
+  Q_OBJECT
+
+private slots:
+  void rules_data() {
+    QTest::addColumn<QStringList>("rules");
+    QTest::addColumn<QByteArray>("json");
+    QTest::addColumn<QByteArray>("expected");
+    const QByteArray doc =
+        R"({"a":{"password":1,"b":{"password":2,"c":3}},"password":4})";
+    QTest::newRow("key pattern")
+        << QStringList{"PASS"} << doc << QByteArray(R"({"a":{"b":{"c":3}}})");
+    QTest::newRow("pointer")
+        << QStringList{"/a/b"} << doc
+        << QByteArray(R"({"a":{"password":1},"password":4})");
+    QTest::newRow("any") << QStringList{"/*/password"} << doc
+                         << QByteArray(R"({"a":{"b":{"password":2,"c":3}},)"
+                                       R"("password":4})");
+    QTest::newRow("any run") << QStringList{"/**/password"} << doc
+                             << QByteArray(R"({"a":{"b":{"c":3}}})");
+    QTest::newRow("empty run")
+        << QStringList{"/a/**/password"} << doc
+        << QByteArray(R"({"a":{"b":{"c":3}},"password":4})");
+    QTest::newRow("trailing run")
+        << QStringList{"/a/**"} << doc << QByteArray(R"({"password":4})");
+    QTest::newRow("everything")
+        << QStringList{"/**"} << doc << QByteArray("{}");
+    QTest::newRow("index")
+        << QStringList{"/1", "/2/x"} << QByteArray(R"([0,1,{"x":1,"y":2}])")
+        << QByteArray(R"([0,{"y":2}])");
+    QTest::newRow("escaped") << QStringList{"/a~1b/~0"}
+                             << QByteArray(R"({"a/b":{"~":1,"k":2}})")
+                             << QByteArray(R"({"a/b":{"k":2}})");
+  }
+  void rules() {
+    QFETCH(QStringList, rules);
+    QFETCH(QByteArray, json);
+    QFETCH(QByteArray, expected);
+    QCOMPARE(filtered(rules, json), QJsonDocument::fromJson(expected));
+    // Lazy trees filter their pending children by the same rules
+    QCOMPARE(filtered(rules, json, true), QJsonDocument::fromJson(expected));
+  }
+
+  // Rows of a filtered array no longer match the source indexes that the
+  // rules of its elements' subtrees are written against
+  void lazyIndexAfterSkip() {
+    const QStringList rules{"/items/1", "/items/3/secret"};
+    const QByteArray json = R"({"items":[{"n":0},{"n":1},{"n":2},)"
+                            R"({"n":3,"secret":"s"},{"n":4,"secret":"t"}]})";
+    const QJsonDocument expected = QJsonDocument::fromJson(
+        R"({"items":[{"n":0},{"n":2},{"n":3},{"n":4,"secret":"t"}]})");
+    QCOMPARE(filtered(rules, json), expected);
+    QCOMPARE(filtered(rules, json, true), expected);
+
+    QJsonModel model;
+    model.addException(rules);
+    model.setLazyLoading(true);
+    QVERIFY(model.loadJson(json));
+    const QModelIndex items = model.indexForPath("/items");
+    QCOMPARE(keys(model, items).size(), 4);
+    QCOMPARE(keys(model, model.index(2, 0, items)), QStringList{"n"});
+    QCOMPARE(keys(model, model.index(3, 0, items)),
+             (QStringList{"n", "secret"}));
+  }
+};
+
+QTEST_GUILESS_MAIN(QJsonFilterTest)
+
+#include "QJsonFilterTest.moc"
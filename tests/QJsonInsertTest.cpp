@@ -0,0 +1,118 @@
+/* QJsonInsertTest.cpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "QJsonModel.hpp"
+#include <QTest>
+
+namespace {
+QJsonValue parse(const QByteArray &json) {
+  return QJsonDocument::fromJson("[" + json + "]").array().at(0);
+}
+} // namespace
+
+class QJsonInsertTest : public QObject {
+  Q_OBJECT
+
+private slots:
+  // Inserted values, containers included, come back out of json() as
+  // they went in
+  void insertValue_data() {
+    QTest::addColumn<QByteArray>("document");
+    QTest::addColumn<QByteArray>("value");
+    QTest::addColumn<QByteArray>("result");
+    QTest::newRow("object into object")
+        << QByteArray(R"({"a":1})")
+        << QByteArray(R"({"x":[1,{"y":null}],"z":"s"})")
+        << QByteArray(R"({"a":1,"k":{"x":[1,{"y":null}],"z":"s"}})");
+    QTest::newRow("array into object")
+        << QByteArray(R"({"a":1})") << QByteArray(R"([true,[],{},"t"])")
+        << QByteArray(R"({"a":1,"k":[true,[],{},"t"]})");
+    QTest::newRow("object into array")
+        << QByteArray("[1,2]") << QByteArray(R"({"b":{"c":[2.5]}})")
+        << QByteArray(R"([1,2,{"b":{"c":[2.5]}}])");
+    QTest::newRow("array into array")
+        << QByteArray("[1,2]") << QByteArray("[[3],[4,[5]]]")
+        << QByteArray("[1,2,[[3],[4,[5]]]]");
+    QTest::newRow("empty containers")
+        << QByteArray("[]") << QByteArray("{}") << QByteArray("[{}]");
+    QTest::newRow("scalar") << QByteArray("[]") << QByteArray(R"("s")")
+                            << QByteArray(R"(["s"])");
+  }
+  void insertValue() {
+    QFETCH(QByteArray, document);
+    QFETCH(QByteArray, value);
+    QFETCH(QByteArray, result);
+    QJsonModel model;
+    QVERIFY(model.loadJson(document));
+    const QModelIndex index =
+        model.insertValue({}, -1, parse(value), QStringLiteral("k"));
+    QVERIFY(index.isValid());
+    const auto *item = static_cast<QJsonTreeItem *>(index.internalPointer());
+    QCOMPARE(item->type(), parse(value).type());
+    QCOMPARE(QJsonDocument::fromJson(model.json()),
+             QJsonDocument::fromJson(result));
+    QCOMPARE(QJsonDocument::fromJson(model.json(true)),
+             QJsonDocument::fromJson(result));
+  }
+
+  // Rows inserted from a view are null until setData() gives them a value
+  void insertRowsThenSetData() {
+    QJsonModel model;
+    QVERIFY(model.loadJson(R"({"a":[1]})"));
+    const QModelIndex a = model.index(0, 0);
+    QVERIFY(model.insertRows(1, 2, a));
+    QVERIFY(model.setData(model.index(1, 1, a), "42"));
+    QVERIFY(model.setData(model.index(2, 1, a), "forty-two"));
+    QVERIFY(model.insertRows(1, 1, {}));
+    QVERIFY(model.setData(model.index(1, 1), "true"));
+    const QString key = model.index(1, 0).data().toString();
+
+    QJsonObject expected{{"a", QJsonArray{1, 42, "forty-two"}}};
+    expected.insert(key, true);
+    QCOMPARE(QJsonDocument::fromJson(model.json()).object(), expected);
+    const auto *item =
+        static_cast<QJsonTreeItem *>(model.index(1, 0, a).internalPointer());
+    QCOMPARE(item->type(), QJsonValue::Double);
+    QCOMPARE(item->scalar().kind(), QJsonScalar::Integer);
+  }
+
+  // Paths resolve through inserted objects, with or without a key index
+  void insertLargeObject() {
+    QJsonObject object;
+    for (int i = 0; i < 2 * QJsonTreeItem::KeyIndexThreshold; ++i)
+      object.insert(QStringLiteral("m%1").arg(i), i);
+    QJsonModel model;
+    QVERIFY(model.loadJson("{}"));
+    QVERIFY(model.insertValue({}, 0, object, QStringLiteral("o")).isValid());
+    const QModelIndex member = model.indexForPath(QStringLiteral("/o/m20"));
+    QVERIFY(member.isValid());
+    QCOMPARE(model.data(member.siblingAtColumn(1), Qt::DisplayRole).toInt(),
+             20);
+    QCOMPARE(QJsonDocument::fromJson(model.json()).object(),
+             QJsonObject{{QStringLiteral("o"), object}});
+  }
+};
+
+QTEST_GUILESS_MAIN(QJsonInsertTest)
+#include "QJsonInsertTest.moc"
@@ -0,0 +1,121 @@
+/* QJsonKeyOrderTest.cpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "QJsonModel.hpp"
+#include <QTemporaryFile>
+#include <QTest>
+
+namespace {
+// Keys out of alphabetical order at every level, including inside an array
+const QByteArray unsorted =
+    R"({"b":1,"a":{"z":true,"y":null},"c":[{"q":"x","p":2}],"0":[]})";
+const QByteArray sorted =
+    R"({"0":[],"a":{"y":null,"z":true},"b":1,"c":[{"p":2,"q":"x"}]})";
+
+// Keys of the rows below \a parent, as the view sees them
+QStringList keys(const QJsonModel &model, const QModelIndex &parent) {
+  QStringList keys;
+  for (int row = 0; row < model.rowCount(parent); ++row)
+    keys << model.index(row, 0, parent).data().toString();
+  return keys;
+}
+} // namespace
+
+class QJsonKeyOrderTest : public QObject {
+  Q_OBJECT
+
+private slots:
+  void sortedByDefault() {
+    QJsonModel model;
+    QVERIFY(!model.preserveKeyOrder());
+    QVERIFY(model.loadJson(unsorted));
+    QCOMPARE(model.json(true), sorted);
+    QCOMPARE(keys(model, QModelIndex()),
+             QStringList({"0", "a", "b", "c"}));
+    QCOMPARE(keys(model, model.index(1, 0)), QStringList({"y", "z"}));
+  }
+
+  void documentOrder() {
+    QJsonModel model;
+    model.setPreserveKeyOrder(true);
+    QVERIFY(model.preserveKeyOrder());
+    QVERIFY(model.loadJson(unsorted));
+    QCOMPARE(model.json(true), unsorted);
+    QCOMPARE(keys(model, QModelIndex()),
+             QStringList({"b", "a", "c", "0"}));
+    QCOMPARE(keys(model, model.index(1, 0)), QStringList({"z", "y"}));
+    const QModelIndex element = model.index(0, 0, model.index(2, 0));
+    QCOMPARE(keys(model, element), QStringList({"q", "p"}));
+  }
+
+  void reloadKeepsOrder() {
+    QJsonModel model;
+    model.setPreserveKeyOrder(true);
+    QVERIFY(model.loadJson(unsorted));
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    QVERIFY(model.save(file.fileName(), true));
+
+    QJsonModel reloaded;
+    reloaded.setPreserveKeyOrder(true);
+    QVERIFY(reloaded.load(file.fileName()));
+    QCOMPARE(reloaded.json(true), unsorted);
+
+    // Loading the saved file into the same model again changes nothing
+    QVERIFY(model.load(file.fileName()));
+    QCOMPARE(model.json(true), unsorted);
+
+    // Without the setting the same file comes back sorted
+    QJsonModel plain;
+    QVERIFY(plain.load(file.fileName()));
+    QCOMPARE(plain.json(true), sorted);
+  }
+
+  void indentedOutput() {
+    QJsonModel model;
+    model.setPreserveKeyOrder(true);
+    QVERIFY(model.loadJson(unsorted));
+    const QByteArray indented = model.json(false);
+    QVERIFY(indented.indexOf("\"b\"") < indented.indexOf("\"a\""));
+    QVERIFY(indented.indexOf("\"z\"") < indented.indexOf("\"y\""));
+
+    QJsonModel reloaded;
+    reloaded.setPreserveKeyOrder(true);
+    QVERIFY(reloaded.loadJson(indented));
+    QCOMPARE(reloaded.json(true), unsorted);
+  }
+
+  void duplicateKeys() {
+    // The last duplicate wins, in its own position
+    QJsonModel model;
+    model.setPreserveKeyOrder(true);
+    QVERIFY(model.loadJson(R"({"b":1,"a":2,"b":3})"));
+    QCOMPARE(model.json(true), QByteArray(R"({"a":2,"b":3})"));
+  }
+};
+
+QTEST_GUILESS_MAIN(QJsonKeyOrderTest)
+
+#include "QJsonKeyOrderTest.moc"
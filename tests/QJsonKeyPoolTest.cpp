@@ -0,0 +1,129 @@
+/* QJsonKeyPoolTest.cpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "QJsonModel.hpp"
+#include <QTest>
+
+namespace {
+// Three records with the same two keys: two repeats of each key, and three
+// array indices the elements derive from their row
+const QByteArray records =
+    R"([{"id":1,"name":"a"},{"id":2,"name":"b"},{"id":3,"name":"c"}])";
+
+qint64 recordsSaved() {
+  return 3 * QJsonKeyPool::stringBytes(1) + 2 * QJsonKeyPool::stringBytes(2) +
+         2 * QJsonKeyPool::stringBytes(4);
+}
+
+const QJsonTreeItem *item(const QModelIndex &index) {
+  return static_cast<const QJsonTreeItem *>(index.internalPointer());
+}
+
+// Fetches every lazy child below \a parent
+void fetchAll(QJsonModel &model, const QModelIndex &parent) {
+  while (model.canFetchMore(parent))
+    model.fetchMore(parent);
+  for (int row = 0; row < model.rowCount(parent); ++row)
+    fetchAll(model, model.index(row, 0, parent));
+}
+} // namespace
+
+class QJsonKeyPoolTest : public QObject {
+  Q_OBJECT
+
+private slots:
+  void pool() {
+    QJsonKeyPool pool;
+    const QString first = pool.intern(QStringLiteral("name"));
+    const QString second = pool.intern(QStringLiteral("name"));
+    QCOMPARE(second, QStringLiteral("name"));
+    QCOMPARE(second.constData(), first.constData());
+    QCOMPARE(pool.count(), qsizetype(1));
+    QCOMPARE(pool.bytesSaved(), QJsonKeyPool::stringBytes(4));
+
+    pool.intern(QStringLiteral("id"));
+    pool.skipIndex(0);
+    pool.skipIndex(123);
+    QCOMPARE(pool.count(), qsizetype(2));
+    QCOMPARE(pool.bytesSaved(), QJsonKeyPool::stringBytes(4) +
+                                    QJsonKeyPool::stringBytes(1) +
+                                    QJsonKeyPool::stringBytes(3));
+
+    pool.clear();
+    QCOMPARE(pool.count(), qsizetype(0));
+    QCOMPARE(pool.bytesSaved(), qint64(0));
+  }
+
+  void keysShareStorage() {
+    QJsonModel model;
+    QVERIFY(model.loadJson(records));
+    QCOMPARE(model.rowCount(), 3);
+    for (int column = 0; column < 2; ++column) {
+      const QString first =
+          item(model.index(column, 0, model.index(0, 0)))->key();
+      for (int row = 1; row < 3; ++row) {
+        const QString key =
+            item(model.index(column, 0, model.index(row, 0)))->key();
+        QCOMPARE(key, first);
+        QCOMPARE(key.constData(), first.constData());
+      }
+    }
+  }
+
+  void bytesSaved() {
+    QJsonModel model;
+    QCOMPARE(model.keyBytesSaved(), qint64(0));
+    QVERIFY(model.loadJson(records));
+    QCOMPARE(model.keyBytesSaved(), recordsSaved());
+
+    // Distinct keys save nothing; the figure is replaced, not added to
+    QVERIFY(model.loadJson(R"({"a":1,"b":{"c":2}})"));
+    QCOMPARE(model.keyBytesSaved(), qint64(0));
+
+    // 1000 records of a repeated "k" holding a single-element array
+    QByteArray json = "[";
+    for (int i = 0; i < 1000; ++i)
+      json += QByteArray(i ? "," : "") + R"({"k":[0]})";
+    QVERIFY(model.loadJson(json + ']'));
+    qint64 indices = 0;
+    for (int i = 0; i < 1000; ++i)
+      indices += QJsonKeyPool::stringBytes(QString::number(i).size()) +
+                 QJsonKeyPool::stringBytes(1);
+    QCOMPARE(model.keyBytesSaved(),
+             indices + 999 * QJsonKeyPool::stringBytes(1));
+  }
+
+  void lazyBytesSaved() {
+    QJsonModel model;
+    model.setLazyLoading(true);
+    model.setFetchBatchSize(1);
+    QVERIFY(model.loadJson(records));
+    fetchAll(model, QModelIndex());
+    QCOMPARE(model.keyBytesSaved(), recordsSaved());
+  }
+};
+
+QTEST_GUILESS_MAIN(QJsonKeyPoolTest)
+
+#include "QJsonKeyPoolTest.moc"
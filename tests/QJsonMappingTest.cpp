@@ -0,0 +1,158 @@
+/* QJsonMappingTest.cpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "QJsonModel.hpp"
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace {
+const QByteArray document =
+    R"({"z":"last","a":[1,-0,2.5,12345678901234567890,true,null],)"
+    R"("text":"café \"quoted\" 服务器","nested":{"k":{"deep":[]}}})";
+
+bool writeFile(const QString &fileName, const QByteArray &data) {
+  QFile file(fileName);
+  return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+}
+} // namespace
+
+class QJsonMappingTest : public QObject {
+  Q_OBJECT
+
+private:
+  QTemporaryDir mDir;
+  QString mFile;
+
+private slots:
+  void init() {
+    QVERIFY(mDir.isValid());
+    mFile = mDir.filePath(QStringLiteral("document.json"));
+    QVERIFY(writeFile(mFile, document));
+  }
+
+  void setting() {
+    QJsonModel model;
+    QVERIFY(!model.memoryMapping());
+    model.setMemoryMapping(true);
+    QVERIFY(model.memoryMapping());
+    model.setMemoryMapping(false);
+    QVERIFY(!model.memoryMapping());
+  }
+
+  void sameTree_data() {
+    QTest::addColumn<bool>("lazy");
+    QTest::addColumn<bool>("keepKeyOrder");
+    QTest::newRow("native parser") << false << false;
+    QTest::newRow("document order") << false << true;
+    QTest::newRow("lazy") << true << false;
+  }
+
+  void sameTree() {
+    QFETCH(bool, lazy);
+    QFETCH(bool, keepKeyOrder);
+
+    QJsonModel mapped;
+    mapped.setMemoryMapping(true);
+    mapped.setLazyLoading(lazy);
+    mapped.setPreserveKeyOrder(keepKeyOrder);
+    QJsonModel read;
+    read.setLazyLoading(lazy);
+    read.setPreserveKeyOrder(keepKeyOrder);
+    QVERIFY(mapped.load(mFile));
+    QVERIFY(read.load(mFile));
+    QCOMPARE(mapped.json(true), read.json(true));
+  }
+
+  void nothingRefersToTheFile() {
+    QJsonModel model;
+    model.setMemoryMapping(true);
+    QVERIFY(model.load(mFile));
+    const QByteArray before = model.json(true);
+
+    // Same size, other bytes: a node pointing into the mapping would see
+    // them. Then the file goes altogether.
+    QByteArray other = document;
+    other.replace("last", "LAST");
+    QVERIFY(writeFile(mFile, other));
+    QCOMPARE(model.json(true), before);
+    QVERIFY(QFile::remove(mFile));
+    QCOMPARE(model.json(true), before);
+    QCOMPARE(model.indexForPath("/z").siblingAtColumn(1).data().toString(),
+             QStringLiteral("last"));
+  }
+
+  void unmappable() {
+    // An empty file cannot be mapped: it is read, and fails, as without
+    const QString empty = mDir.filePath(QStringLiteral("empty.json"));
+    QVERIFY(writeFile(empty, QByteArray()));
+    QJsonModel mapped;
+    mapped.setMemoryMapping(true);
+    QVERIFY(mapped.loadJson("[\"kept\"]"));
+    QJsonModel read;
+    QVERIFY(!mapped.load(empty));
+    QVERIFY(!read.load(empty));
+    QCOMPARE(mapped.parseError().error, read.parseError().error);
+    QCOMPARE(mapped.json(true), QByteArray(R"(["kept"])"));
+
+    QVERIFY(!mapped.load(mDir.filePath(QStringLiteral("missing.json"))));
+  }
+
+  void statistics() {
+    QJsonModel model;
+    model.setMemoryMapping(true);
+    model.setStatisticsEnabled(true);
+    QVERIFY(model.load(mFile));
+    QCOMPARE(model.statistics().loadedBytes, qint64(document.size()));
+  }
+
+  void async() {
+    QJsonModel model;
+    model.setMemoryMapping(true);
+    QSignalSpy finished(&model, &QJsonModel::loadFinished);
+    QList<qint64> bytesRead;
+    connect(&model, &QJsonModel::loadProgress, this,
+            [&](qint64 bytes, qint64 total, qint64) {
+              QCOMPARE(total, qint64(document.size()));
+              bytesRead << bytes;
+            });
+
+    QVERIFY(model.loadAsync(mFile));
+    QVERIFY(finished.wait(10000));
+    QCOMPARE(finished.first().first().toBool(), true);
+    // The mapping is all there at once: no partial reads
+    QVERIFY(!bytesRead.isEmpty());
+    for (qint64 bytes : std::as_const(bytesRead))
+      QCOMPARE(bytes, qint64(document.size()));
+
+    QJsonModel read;
+    QVERIFY(read.load(mFile));
+    QCOMPARE(model.json(true), read.json(true));
+  }
+};
+
+QTEST_GUILESS_MAIN(QJsonMappingTest)
+
+#include "QJsonMappingTest.moc"
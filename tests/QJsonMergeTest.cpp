@@ -0,0 +1,97 @@
+/* QJsonMergeTest.cpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "QJsonModel.hpp"
+#include <QSignalSpy>
+#include <QTest>
+
+class QJsonMergeTest : public QObject {
+  Q_OBJECT
+
+private slots:
+  void merge_data() {
+    QTest::addColumn<QByteArray>("before");
+    QTest::addColumn<QByteArray>("after");
+    QTest::newRow("same") << QByteArray(R"({"a":1,"b":[1,2]})")
+                          << QByteArray(R"({"a":1,"b":[1,2]})");
+    QTest::newRow("value")
+        << QByteArray(R"({"a":1,"b":"x"})") << QByteArray(R"({"a":2,"b":"y"})");
+    QTest::newRow("type") << QByteArray(R"({"a":1,"b":[1]})")
+                          << QByteArray(R"({"a":"1","b":{}})");
+    QTest::newRow("grow array")
+        << QByteArray("[1,2]") << QByteArray("[1,2,3,[4,5]]");
+    QTest::newRow("shrink array")
+        << QByteArray("[1,2,3,[4,5]]") << QByteArray("[1]");
+    QTest::newRow("keys") << QByteArray(R"({"a":1,"c":3,"e":5})")
+                          << QByteArray(R"({"b":2,"c":3,"d":4})");
+    QTest::newRow("deep") << QByteArray(R"({"x":{"y":[{"z":1},{"z":2}]}})")
+                          << QByteArray(R"({"x":{"y":[{"z":1},{"w":2}]}})");
+    QTest::newRow("root kind") << QByteArray(R"({"a":1})")
+                               << QByteArray("[1]");
+  }
+  void merge() {
+    QFETCH(QByteArray, before);
+    QFETCH(QByteArray, after);
+    QJsonModel model;
+    model.setIncrementalReload(true);
+    QVERIFY(model.loadJson(before));
+    QVERIFY(model.loadJson(after));
+    QCOMPARE(QJsonDocument::fromJson(model.json()),
+             QJsonDocument::fromJson(after));
+  }
+
+  void keepsIndexes() {
+    QJsonModel model;
+    model.setIncrementalReload(true);
+    QVERIFY(model.loadJson(R"({"list":[1,2,3],"name":"a","gone":0})"));
+    const QPersistentModelIndex list = model.indexForPath("/list");
+    const QPersistentModelIndex second = model.indexForPath("/list/1");
+    QVERIFY(second.isValid());
+
+    QSignalSpy resets(&model, &QAbstractItemModel::modelReset);
+    QSignalSpy changes(&model, &QAbstractItemModel::dataChanged);
+    QSignalSpy removals(&model, &QAbstractItemModel::rowsRemoved);
+    QVERIFY(model.loadJson(R"({"list":[1,9,3],"name":"a"})"));
+    QCOMPARE(resets.count(), 0);
+    QCOMPARE(removals.count(), 1);
+    QCOMPARE(changes.count(), 1);
+    QVERIFY(list.isValid());
+    QVERIFY(second.isValid());
+    QCOMPARE(second.sibling(second.row(), 1).data().toInt(), 9);
+  }
+
+  void failedReload() {
+    QJsonModel model;
+    model.setIncrementalReload(true);
+    QVERIFY(model.loadJson(R"({"a":[1,2,3]})"));
+    const QByteArray before = model.json();
+    // Fails after part of the tree was built on the heap
+    QVERIFY(!model.loadJson(R"({"a":[1,2,3],"b":[4,5,)"));
+    QCOMPARE(model.json(), before);
+  }
+};
+
+QTEST_GUILESS_MAIN(QJsonMergeTest)
+
+#include "QJsonMergeTest.moc"
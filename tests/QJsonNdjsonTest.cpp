@@ -0,0 +1,216 @@
+/* QJsonNdjsonTest.cpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "QJsonModel.hpp"
+#include <QBuffer>
+#include <QSignalSpy>
+#include <QTemporaryFile>
+#include <QTest>
+
+namespace {
+// \a count records {"n":first}, {"n":first + 1}, ..., one per line
+QByteArray records(int first, int count) {
+  QByteArray lines;
+  for (int i = first; i < first + count; ++i)
+    lines += R"({"n":)" + QByteArray::number(i) + "}\n";
+  return lines;
+}
+
+// Keys of the top-level rows, which are the record numbers
+QStringList keys(const QJsonModel &model) {
+  QStringList keys;
+  for (int row = 0; row < model.rowCount(); ++row)
+    keys << model.index(row, 0).data().toString();
+  return keys;
+}
+} // namespace
+
+class QJsonNdjsonTest : public QObject {
+  Q_OBJECT
+
+private slots:
+  void append() {
+    QJsonModel model;
+    QVERIFY(model.loadJson(R"({"replaced":true})"));
+    QSignalSpy inserted(&model, &QJsonModel::rowsInserted);
+
+    model.appendNdjson(R"({"a":1})" "\n" "[2]\n" R"("three")" "\n");
+    // Queued until the event loop comes round, then inserted at once
+    QCOMPARE(model.rowCount(), 0);
+    QTRY_COMPARE(model.rowCount(), 3);
+    QCOMPARE(inserted.count(), 1);
+    QCOMPARE(model.json(true), QByteArray(R"([{"a":1},[2],"three"])"));
+    QCOMPARE(keys(model), QStringList({"0", "1", "2"}));
+
+    // Later records go on from there
+    model.appendNdjson("4\n");
+    model.flushNdjson();
+    QCOMPARE(inserted.count(), 2);
+    QCOMPARE(model.json(true), QByteArray(R"([{"a":1},[2],"three",4])"));
+    QCOMPARE(keys(model), QStringList({"0", "1", "2", "3"}));
+  }
+
+  void splitRecord() {
+    QJsonModel model;
+    // Split inside a key, then inside a two-byte UTF-8 sequence
+    const QByteArray line = "{\"name\":\"caf\xc3\xa9\"}\n";
+    const qsizetype inCharacter = line.indexOf('\xc3') + 1;
+    model.appendNdjson(line.left(4));
+    model.flushNdjson();
+    QCOMPARE(model.rowCount(), 0);
+    model.appendNdjson(line.mid(4, inCharacter - 4));
+    model.flushNdjson();
+    QCOMPARE(model.rowCount(), 0);
+    model.appendNdjson(line.mid(inCharacter) + R"({"name":)");
+    model.flushNdjson();
+    QCOMPARE(model.rowCount(), 1);
+    QCOMPARE(model.index(0, 1, model.index(0, 0)).data().toString(),
+             QString::fromUtf8("caf\xc3\xa9"));
+
+    model.appendNdjson(R"("next"})" "\n");
+    model.flushNdjson();
+    QCOMPARE(model.rowCount(), 2);
+    QCOMPARE(keys(model), QStringList({"0", "1"}));
+  }
+
+  void blankAndMalformedLines() {
+    QJsonModel model;
+    model.appendNdjson("\n"
+                       "  \t\n"
+                       R"({"a":1})" "\n"
+                       "not json\n"
+                       R"({"b":)" "\n"
+                       "[1,2] 3\n"
+                       "1,2\n"
+                       R"({"c":3})" "\r\n"
+                       "\n");
+    model.flushNdjson();
+    // Skipped lines take no record number
+    QCOMPARE(model.json(true), QByteArray(R"([{"a":1},{"c":3}])"));
+    QCOMPARE(keys(model), QStringList({"0", "1"}));
+  }
+
+  void device() {
+    QBuffer buffer;
+    buffer.setData(records(0, 2) + R"({"n":)");
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+
+    // What the device holds is read on attaching; the partial last line
+    // waits for the rest
+    QJsonModel model;
+    model.setNdjsonDevice(&buffer);
+    model.flushNdjson();
+    QCOMPARE(model.json(true), QByteArray(R"([{"n":0},{"n":1}])"));
+  }
+
+  void growingFile() {
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    QFile reader(file.fileName());
+    QVERIFY(reader.open(QIODevice::ReadOnly | QIODevice::Unbuffered));
+
+    QJsonModel model;
+    model.setNdjsonDevice(&reader);
+    QCOMPARE(model.rowCount(), 0);
+
+    // QFile never emits readyRead(): readNdjson() picks up what was added
+    file.write(records(0, 3));
+    QVERIFY(file.flush());
+    model.readNdjson();
+    model.flushNdjson();
+    QCOMPARE(keys(model), QStringList({"0", "1", "2"}));
+
+    // Detached, the device is left alone
+    model.setNdjsonDevice(nullptr);
+    file.write(records(3, 1));
+    QVERIFY(file.flush());
+    model.readNdjson();
+    model.flushNdjson();
+    QCOMPARE(model.rowCount(), 3);
+  }
+
+  void maxRows() {
+    QJsonModel model;
+    model.setMaxRows(3);
+    QCOMPARE(model.maxRows(), 3);
+    QSignalSpy inserted(&model, &QJsonModel::rowsInserted);
+    QSignalSpy removed(&model, &QJsonModel::rowsRemoved);
+
+    // Records dropped on arrival never reach the view
+    model.appendNdjson(records(0, 5));
+    model.flushNdjson();
+    QCOMPARE(removed.count(), 0);
+    QCOMPARE(inserted.count(), 1);
+    QCOMPARE(model.json(true), QByteArray(R"([{"n":2},{"n":3},{"n":4}])"));
+
+    // The oldest rows go; the rows renumber, the record keys stay
+    model.appendNdjson(records(5, 2));
+    model.flushNdjson();
+    QCOMPARE(removed.count(), 1);
+    QCOMPARE(removed.at(0).at(1).toInt(), 0);
+    QCOMPARE(removed.at(0).at(2).toInt(), 1);
+    QCOMPARE(keys(model), QStringList({"4", "5", "6"}));
+    for (int row = 0; row < 3; ++row) {
+      const QModelIndex record = model.index(row, 0);
+      QCOMPARE(record.row(), row);
+      QCOMPARE(model.pathForIndex(record),
+               QStringLiteral("/") + QString::number(row));
+      QCOMPARE(model.index(0, 1, record).data().toInt(), row + 4);
+    }
+
+    // Lowering the limit trims right away
+    model.setMaxRows(1);
+    QCOMPARE(removed.count(), 2);
+    QCOMPARE(keys(model), QStringList({"6"}));
+    model.setMaxRows(0);
+    model.appendNdjson(records(7, 2));
+    model.flushNdjson();
+    QCOMPARE(keys(model), QStringList({"6", "7", "8"}));
+  }
+
+  void trimClearsUndo() {
+    QJsonModel model;
+    model.setUndoLimit(10);
+    model.setMaxRows(2);
+    model.appendNdjson(records(0, 2));
+    model.flushNdjson();
+    QVERIFY(model.setData(model.index(0, 1, model.index(1, 0)), 10));
+    QVERIFY(model.canUndo());
+    QSignalSpy canUndo(&model, &QJsonModel::canUndoChanged);
+
+    // The edited record is not the one trimmed, but the history goes all
+    // the same: its rows no longer say where the edits were
+    model.appendNdjson(records(2, 1));
+    model.flushNdjson();
+    QVERIFY(!model.canUndo());
+    QCOMPARE(canUndo.count(), 1);
+    QCOMPARE(canUndo.at(0).at(0).toBool(), false);
+    QVERIFY(!model.undo());
+    QCOMPARE(model.json(true), QByteArray(R"([{"n":10},{"n":2}])"));
+  }
+};
+
+QTEST_GUILESS_MAIN(QJsonNdjsonTest)
+
+#include "QJsonNdjsonTest.moc"
@@ -0,0 +1,213 @@
+/* QJsonParallelTest.cpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "QJsonModel.hpp"
+#include <QFile>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace {
+// One member of a wide container: every scalar kind, nested containers,
+// and keys repeated in every member, so in every chunk
+QByteArray member(int i) {
+  const QByteArray n = QByteArray::number(i);
+  return R"({"id":)" + n + R"(,"name":"n-)" + n + R"(","v":)" + n +
+         R"(.5,"big":12345678901234567890,"ok":)" +
+         (i % 2 ? "true" : "false") + R"(,"nil":null,"tags":[)" + n +
+         R"(,"x",{"deep":-0}],"esc":"é\n"})";
+}
+
+// A wide array, or a wide object whose keys are out of order
+QByteArray wide(bool object, int count) {
+  QByteArray json = object ? "{" : "[";
+  for (int i = 0; i < count; ++i) {
+    if (i)
+      json += ',';
+    if (object)
+      json += "\"k" + QByteArray::number(count - i) + "\":";
+    json += member(i);
+  }
+  return json + (object ? '}' : ']');
+}
+
+void configure(QJsonModel &model, bool parallel) {
+  if (parallel) {
+    // Several threads even on a single core; any wide top level is split
+    model.setLoadThreadCount(4);
+    model.setParallelThreshold(0);
+  } else {
+    model.setLoadThreadCount(1);
+  }
+}
+
+const QJsonTreeItem *item(const QModelIndex &index) {
+  return static_cast<const QJsonTreeItem *>(index.internalPointer());
+}
+
+// Compares the trees below \a a and \a b node by node: keys, order, types
+// and scalar kinds. Returns the first difference, if any.
+QString compare(const QJsonModel &first, const QModelIndex &a,
+                const QJsonModel &second, const QModelIndex &b) {
+  if (first.rowCount(a) != second.rowCount(b))
+    return "row count at " + first.pathForIndex(a);
+  for (int row = 0; row < first.rowCount(a); ++row) {
+    const QModelIndex x = first.index(row, 0, a);
+    const QModelIndex y = second.index(row, 0, b);
+    if (item(x)->key() != item(y)->key() ||
+        item(x)->type() != item(y)->type() ||
+        item(x)->scalar().kind() != item(y)->scalar().kind() ||
+        item(x)->scalar() != item(y)->scalar())
+      return "node " + first.pathForIndex(x);
+    const QString below = compare(first, x, second, y);
+    if (!below.isEmpty())
+      return below;
+  }
+  return {};
+}
+} // namespace
+
+class QJsonParallelTest : public QObject {
+  Q_OBJECT
+
+private slots:
+  void sameTree_data() {
+    QTest::addColumn<bool>("object");
+    QTest::addColumn<bool>("keepKeyOrder");
+    QTest::newRow("array") << false << false;
+    QTest::newRow("object") << true << false;
+    QTest::newRow("object in document order") << true << true;
+  }
+
+  void sameTree() {
+    QFETCH(bool, object);
+    QFETCH(bool, keepKeyOrder);
+    constexpr int count = 5000;
+    const QByteArray json = wide(object, count);
+
+    QJsonModel parallel;
+    configure(parallel, true);
+    parallel.setPreserveKeyOrder(keepKeyOrder);
+    QVERIFY(parallel.loadJson(json));
+    QJsonModel sequential;
+    configure(sequential, false);
+    sequential.setPreserveKeyOrder(keepKeyOrder);
+    QVERIFY(sequential.loadJson(json));
+
+    QCOMPARE(parallel.rowCount(), count);
+    QCOMPARE(parallel.json(true), sequential.json(true));
+    QCOMPARE(parallel.json(), sequential.json());
+    const QString difference =
+        compare(parallel, QModelIndex(), sequential, QModelIndex());
+    QVERIFY2(difference.isEmpty(), qPrintable(difference));
+
+    // Keys built by different chunks are found through the same lookups
+    for (int i = 0; i < count; i += 97) {
+      const QString path = object ? "/k" + QString::number(count - i)
+                                  : "/" + QString::number(i);
+      const QModelIndex index = parallel.indexForPath(path + "/tags/2/deep");
+      QVERIFY2(index.isValid(), qPrintable(path));
+      QCOMPARE(parallel.pathForIndex(index), path + "/tags/2/deep");
+      QCOMPARE(parallel.indexForPath(path + "/name")
+                   .siblingAtColumn(1)
+                   .data()
+                   .toString(),
+               "n-" + QString::number(i));
+    }
+    // Each chunk has a pool of its own: repeats are only shared within one
+    QVERIFY(parallel.keyBytesSaved() > 0);
+    QVERIFY(parallel.keyBytesSaved() <= sequential.keyBytesSaved());
+  }
+
+  void syntaxError_data() {
+    QTest::addColumn<QByteArray>("damage");
+    QTest::newRow("literal") << QByteArray("tru");
+    QTest::newRow("number") << QByteArray("-");
+    QTest::newRow("escape") << QByteArray(R"("\x")");
+    QTest::newRow("unterminated object") << QByteArray(R"({"a":1)");
+    QTest::newRow("missing separator") << QByteArray(R"([1 2])");
+  }
+
+  void syntaxError() {
+    QFETCH(QByteArray, damage);
+    // Well inside one of the chunks
+    QByteArray json = wide(false, 2000);
+    const QByteArray target = member(1234);
+    const qsizetype at = json.indexOf(target);
+    QVERIFY(at > 0);
+    json.replace(at, target.size(), damage);
+
+    QJsonModel parallel;
+    configure(parallel, true);
+    QVERIFY(parallel.loadJson("[\"kept\"]"));
+    QJsonModel sequential;
+    configure(sequential, false);
+    QVERIFY(!parallel.loadJson(json));
+    QVERIFY(!sequential.loadJson(json));
+
+    QVERIFY(parallel.parseError().error != QJsonParseError::NoError);
+    QCOMPARE(parallel.parseError().error, sequential.parseError().error);
+    QCOMPARE(parallel.parseError().offset, sequential.parseError().offset);
+    QVERIFY(parallel.parseError().offset >= at);
+    QCOMPARE(parallel.json(true), QByteArray(R"(["kept"])"));
+  }
+
+  void cancel() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath(QStringLiteral("wide.json"));
+    {
+      QFile file(fileName);
+      QVERIFY(file.open(QIODevice::WriteOnly));
+      file.write(wide(false, 100000));
+    }
+
+    QJsonModel model;
+    configure(model, true);
+    QVERIFY(model.loadJson("[\"kept\"]"));
+    QSignalSpy finished(&model, &QJsonModel::loadFinished);
+    QSignalSpy resets(&model, &QJsonModel::modelReset);
+    // Cancels once the chunks report built nodes. The outcome is queued
+    // behind the report, so the load fails even if the chunks were done.
+    connect(&model, &QJsonModel::loadProgress, this,
+            [&](qint64, qint64, qint64 nodes) {
+              if (nodes > 0)
+                model.cancelLoad();
+            });
+
+    QVERIFY(model.loadAsync(fileName));
+    QVERIFY(finished.wait(30000));
+    QCOMPARE(finished.first().first().toBool(), false);
+    QCOMPARE(resets.count(), 0);
+    QCOMPARE(model.json(true), QByteArray(R"(["kept"])"));
+
+    // Nothing of the cancelled chunks is left behind
+    QVERIFY(model.loadJson(wide(false, 10)));
+    QCOMPARE(model.rowCount(), 10);
+  }
+};
+
+QTEST_GUILESS_MAIN(QJsonParallelTest)
+
+#include "QJsonParallelTest.moc"
@@ -0,0 +1,143 @@
+/* QJsonParserTest.cpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "QJsonModel.hpp"
+#include <QTest>
+#include <cmath>
+
+class QJsonParserTest : public QObject {
+  Q_OBJECT
+
+private slots:
+  void roundTrip_data() {
+    QTest::addColumn<QByteArray>("json");
+    QTest::newRow("empty object") << QByteArray("{}");
+    QTest::newRow("empty array") << QByteArray(" [ ] ");
+    QTest::newRow("scalars")
+        << QByteArray(R"({"t":true,"f":false,"n":null,"s":"x","i":-3})");
+    QTest::newRow("nested")
+        << QByteArray(R"({"a":[1,[2,{"b":[]}],{}],"c":{"d":{"e":"f"}}})");
+    QTest::newRow("numbers")
+        << QByteArray("[0,-0,1.5,-2.25e-3,1E10,9007199254740993,"
+                      "123456789012345678901234567890]");
+    QTest::newRow("negative zero") << QByteArray("[-0,-0.0,0,-0e5]");
+    QTest::newRow("escapes")
+        << QByteArray(R"(["\"\\\/\b\f\n\r\t","Aé😀"])");
+    QTest::newRow("utf-8") << QByteArray("[\"h\xc3\xa9llo \xe6\x9c\x8d "
+                                         "\xf0\x9f\x98\x80\"]");
+    QTest::newRow("duplicate keys") << QByteArray(R"({"a":1,"b":2,"a":3})");
+  }
+  void roundTrip() {
+    QFETCH(QByteArray, json);
+    QJsonModel model;
+    QVERIFY(model.loadJson(json));
+    QCOMPARE(model.parseError().error, QJsonParseError::NoError);
+    QCOMPARE(QJsonDocument::fromJson(model.json()),
+             QJsonDocument::fromJson(json));
+    QCOMPARE(QJsonDocument::fromJson(model.json(true)),
+             QJsonDocument::fromJson(json));
+  }
+
+  // QJsonDocument reads "-0" as 0, so the sign is checked in the text
+  void negativeZero() {
+    QJsonModel model;
+    QVERIFY(model.loadJson("[-0,-0.0,0]"));
+    QCOMPARE(model.json(true), QByteArray("[-0,-0,0]"));
+    QVERIFY(std::signbit(model.index(0, 1).data().toDouble()));
+  }
+
+  void exactIntegers() {
+    QJsonModel model;
+    QVERIFY(model.loadJson("[9007199254740993,-123456789012345678901]"));
+    const QByteArray json = model.json(true);
+    QVERIFY2(json.contains("9007199254740993"), json.constData());
+    QVERIFY2(json.contains("-123456789012345678901"), json.constData());
+  }
+
+  void invalid_data() {
+    QTest::addColumn<QByteArray>("json");
+    QTest::newRow("empty") << QByteArray("");
+    QTest::newRow("scalar root") << QByteArray("1");
+    QTest::newRow("trailing comma") << QByteArray("[1,]");
+    QTest::newRow("missing colon") << QByteArray(R"({"a" 1})");
+    QTest::newRow("unterminated") << QByteArray(R"({"a":[1,2})");
+    QTest::newRow("garbage") << QByteArray("{} x");
+    QTest::newRow("leading zero") << QByteArray("[01]");
+    QTest::newRow("bare dot") << QByteArray("[1.]");
+    QTest::newRow("bad literal") << QByteArray("[tru]");
+    QTest::newRow("bad escape") << QByteArray(R"(["\q"])");
+    QTest::newRow("short unicode") << QByteArray(R"(["\u12"])");
+    QTest::newRow("control") << QByteArray("[\"a\x01\"]");
+    QTest::newRow("lone byte") << QByteArray("[\"\xc3\"]");
+    QTest::newRow("overlong") << QByteArray("[\"\xc0\xaf\"]");
+    QTest::newRow("surrogate") << QByteArray("[\"\xed\xa0\x80\"]");
+    QTest::newRow("deep") << QByteArray(2000, '[') + QByteArray(2000, ']');
+  }
+  void invalid() {
+    QFETCH(QByteArray, json);
+    QJsonModel model;
+    QVERIFY(model.loadJson(R"({"kept":true})"));
+    const QByteArray before = model.json();
+    QVERIFY(!model.loadJson(json));
+    QVERIFY(model.parseError().error != QJsonParseError::NoError);
+    // A failed load leaves the current tree as it was
+    QCOMPARE(model.json(), before);
+  }
+
+  // Skipped members are never built, but must be just as valid
+  void invalidSkipped_data() {
+    QTest::addColumn<QByteArray>("value");
+    QTest::newRow("bad escape") << QByteArray(R"("\q")");
+    QTest::newRow("bad unicode") << QByteArray(R"("\u12g4")");
+    QTest::newRow("control") << QByteArray("\"a\x01\"");
+    QTest::newRow("lone byte") << QByteArray("\"\xc3\"");
+    QTest::newRow("invalid byte") << QByteArray("\"\xff\"");
+    QTest::newRow("surrogate") << QByteArray("\"\xed\xa0\x80\"");
+    QTest::newRow("nested") << QByteArray(R"([{"k":"\x"}])");
+    QTest::newRow("bad key") << QByteArray("{\"\xc3\":1}");
+    QTest::newRow("number") << QByteArray("[1.e5]");
+  }
+  void invalidSkipped() {
+    QFETCH(QByteArray, value);
+    QJsonModel model;
+    model.addException({"secret"});
+    QVERIFY(model.loadJson(R"({"secret":"ok","open":1})"));
+    QVERIFY(!model.loadJson(R"({"secret":)" + value + R"(,"open":1})"));
+  }
+
+  void skipped() {
+    QJsonModel model;
+    model.addException({"secret"});
+    QVERIFY(model.loadJson(
+        R"({"a":{"secret":[1,{"x":"é"}],"b":2},"my_secret":3})"));
+    const QByteArray json = model.json(true);
+    QVERIFY2(!json.contains("secret"), json.constData());
+    QCOMPARE(QJsonDocument::fromJson(json).object().value("a"),
+             QJsonValue(QJsonObject{{"b", 2}}));
+  }
+};
+
+QTEST_GUILESS_MAIN(QJsonParserTest)
+
+#include "QJsonParserTest.moc"
@@ -0,0 +1,151 @@
+/* QJsonPathTest.cpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "QJsonModel.hpp"
+#include <QTest>
+
+namespace {
+// Keys that need escaping, an empty key and a numeric object key. Sorted,
+// the root rows are "", "0", "a/b", "list" and "m~n".
+const QByteArray document = R"({"a/b":1,"m~n":{"~1":[10,{"":true}]},)"
+                            R"("":"empty","0":null,"list":[[0,1],[2]]})";
+
+// Checks that every index below \a parent maps to a path and back
+int roundTrip(QJsonModel &model, const QModelIndex &parent) {
+  int checked = 0;
+  for (int row = 0; row < model.rowCount(parent); ++row) {
+    const QModelIndex index = model.index(row, 0, parent);
+    const QString path = model.pathForIndex(index);
+    if (model.indexForPath(path) != index)
+      return -1;
+    const int below = roundTrip(model, index);
+    if (below < 0)
+      return -1;
+    checked += 1 + below;
+  }
+  return checked;
+}
+} // namespace
+
+class QJsonPathTest : public QObject {
+  Q_OBJECT
+
+private slots:
+  void paths_data() {
+    QTest::addColumn<QString>("path");
+    QTest::addColumn<QList<int>>("rows");
+
+    QTest::newRow("empty key") << QStringLiteral("/") << QList<int>{0};
+    QTest::newRow("numeric key") << QStringLiteral("/0") << QList<int>{1};
+    QTest::newRow("slash") << QStringLiteral("/a~1b") << QList<int>{2};
+    QTest::newRow("nested arrays")
+        << QStringLiteral("/list/1/0") << QList<int>{3, 1, 0};
+    QTest::newRow("tilde") << QStringLiteral("/m~0n") << QList<int>{4};
+    // The key "~1" must not come back as "/"
+    QTest::newRow("escaped escape")
+        << QStringLiteral("/m~0n/~01") << QList<int>{4, 0};
+    QTest::newRow("deepest")
+        << QStringLiteral("/m~0n/~01/1/") << QList<int>{4, 0, 1, 0};
+  }
+
+  void paths() {
+    QFETCH(QString, path);
+    QFETCH(QList<int>, rows);
+
+    QJsonModel model;
+    QVERIFY(model.loadJson(document));
+    QModelIndex expected;
+    for (int row : rows)
+      expected = model.index(row, 0, expected);
+    QVERIFY(expected.isValid());
+
+    QCOMPARE(model.pathForIndex(expected), path);
+    QCOMPARE(model.indexForPath(path), expected);
+    // Any column of the row has the same path
+    QCOMPARE(model.pathForIndex(expected.siblingAtColumn(1)), path);
+  }
+
+  void keys() {
+    QJsonModel model;
+    QVERIFY(model.loadJson(document));
+    QCOMPARE(model.indexForPath("/a~1b").data().toString(),
+             QStringLiteral("a/b"));
+    QCOMPARE(model.indexForPath("/m~0n").data().toString(),
+             QStringLiteral("m~n"));
+    QCOMPARE(model.indexForPath("/m~0n/~01").data().toString(),
+             QStringLiteral("~1"));
+    QCOMPARE(model.indexForPath("/").siblingAtColumn(1).data().toString(),
+             QStringLiteral("empty"));
+  }
+
+  void everyIndex() {
+    QJsonModel model;
+    QVERIFY(model.loadJson(document));
+    QCOMPARE(roundTrip(model, QModelIndex()), 14);
+  }
+
+  void lazyFetch() {
+    // indexForPath() fetches the children it goes through
+    QJsonModel model;
+    model.setLazyLoading(true);
+    model.setFetchBatchSize(1);
+    QVERIFY(model.loadJson(document));
+    const QModelIndex deepest = model.indexForPath("/m~0n/~01/1/");
+    QVERIFY(deepest.isValid());
+    QCOMPARE(model.pathForIndex(deepest), QStringLiteral("/m~0n/~01/1/"));
+    QVERIFY(roundTrip(model, QModelIndex()) > 0);
+  }
+
+  void invalid_data() {
+    QTest::addColumn<QString>("path");
+
+    QTest::newRow("root") << QString();
+    QTest::newRow("relative") << QStringLiteral("a~1b");
+    QTest::newRow("missing key") << QStringLiteral("/missing");
+    QTest::newRow("unescaped slash") << QStringLiteral("/a/b");
+    QTest::newRow("past the end") << QStringLiteral("/list/2");
+    QTest::newRow("leading zero") << QStringLiteral("/list/01");
+    QTest::newRow("sign") << QStringLiteral("/list/+1");
+    QTest::newRow("append marker") << QStringLiteral("/list/-");
+    QTest::newRow("below a scalar") << QStringLiteral("/0/x");
+  }
+
+  void invalid() {
+    QFETCH(QString, path);
+
+    QJsonModel model;
+    QVERIFY(model.loadJson(document));
+    QVERIFY(!model.indexForPath(path).isValid());
+  }
+
+  void noPathForInvalidIndex() {
+    QJsonModel model;
+    QVERIFY(model.loadJson(document));
+    QVERIFY(model.pathForIndex(QModelIndex()).isEmpty());
+  }
+};
+
+QTEST_GUILESS_MAIN(QJsonPathTest)
+
+#include "QJsonPathTest.moc"
@@ -0,0 +1,107 @@
+/* QJsonSaveTest.cpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "QJsonModel.hpp"
+#include <QBuffer>
+#include <QTemporaryDir>
+#include <QTest>
+
+namespace {
+// Records with nested containers, several times the writer's 64 KiB chunk
+QByteArray records(int count) {
+  QByteArray json = "[";
+  for (int i = 0; i < count; ++i) {
+    if (i)
+      json += ',';
+    json += R"({"id":)" + QByteArray::number(i) +
+            R"(,"name":"record \")" + QByteArray::number(i) +
+            R"(\" é","tags":["a","b",[true,null]],"score":)" +
+            QByteArray::number(i * 0.5) + R"(,"nested":{"x":{"y":[]}}})";
+  }
+  return json + ']';
+}
+} // namespace
+
+class QJsonSaveTest : public QObject {
+  Q_OBJECT
+
+private slots:
+  // save() writes in chunks what json() returns whole; children a lazy
+  // view never fetched are written from the source
+  void save_data() {
+    QTest::addColumn<bool>("lazy");
+    QTest::addColumn<bool>("compact");
+    QTest::newRow("eager/indented") << false << false;
+    QTest::newRow("eager/compact") << false << true;
+    QTest::newRow("lazy/indented") << true << false;
+    QTest::newRow("lazy/compact") << true << true;
+  }
+  void save() {
+    QFETCH(bool, lazy);
+    QFETCH(bool, compact);
+    const QByteArray json = records(2000);
+    QJsonModel model;
+    model.setLazyLoading(lazy);
+    QVERIFY(model.loadJson(json));
+    if (lazy) {
+      // Some records fetched, most not
+      const QModelIndex first = model.index(0, 0);
+      QCOMPARE(model.canFetchMore(first), true);
+      model.fetchMore(first);
+      QVERIFY(model.canFetchMore(model.index(1, 0)));
+    }
+
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::WriteOnly));
+    QVERIFY(model.save(&buffer, compact));
+    QVERIFY(buffer.data().size() > 64 * 1024);
+    QCOMPARE(buffer.data(), model.json(compact));
+    QCOMPARE(QJsonDocument::fromJson(buffer.data()),
+             QJsonDocument::fromJson(json));
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath(QStringLiteral("saved.json"));
+    QVERIFY(model.save(fileName, compact));
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QCOMPARE(file.readAll(), buffer.data());
+
+    // And the saved file loads back to the same output
+    QJsonModel reloaded;
+    QVERIFY(reloaded.load(fileName));
+    QCOMPARE(reloaded.json(compact), buffer.data());
+  }
+
+  void unwritableDevice() {
+    QJsonModel model;
+    QVERIFY(model.loadJson(records(10)));
+    QBuffer buffer;
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+    QVERIFY(!model.save(&buffer));
+  }
+};
+
+QTEST_GUILESS_MAIN(QJsonSaveTest)
+#include "QJsonSaveTest.moc"
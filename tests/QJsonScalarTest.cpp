@@ -0,0 +1,175 @@
+/* QJsonScalarTest.cpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "QJsonModel.hpp"
+#include <QJsonDocument>
+#include <QTest>
+
+Q_DECLARE_METATYPE(QJsonScalar::Kind)
+
+namespace {
+const QJsonTreeItem *item(const QModelIndex &index) {
+  return static_cast<const QJsonTreeItem *>(index.internalPointer());
+}
+} // namespace
+
+class QJsonScalarTest : public QObject {
+  Q_OBJECT
+
+private slots:
+  // Numbers become doubles exactly when the double reads back as the same
+  // decimal value; the others keep their text
+  void numbers_data() {
+    QTest::addColumn<QByteArray>("number");
+    QTest::addColumn<QJsonScalar::Kind>("kind");
+    QTest::newRow("integer") << QByteArray("9007199254740993")
+                             << QJsonScalar::Integer;
+    QTest::newRow("short") << QByteArray("-0.5") << QJsonScalar::Double;
+    QTest::newRow("16 digits") << QByteArray("3.141592653589793")
+                               << QJsonScalar::Double;
+    QTest::newRow("17 digits") << QByteArray("0.30000000000000004")
+                               << QJsonScalar::Double;
+    QTest::newRow("trailing zeros") << QByteArray("2.50000000000000000000")
+                                    << QJsonScalar::Double;
+    QTest::newRow("exponent") << QByteArray("1.2345678901234567E+300")
+                              << QJsonScalar::Double;
+    QTest::newRow("past qint64") << QByteArray("100000000000000000000")
+                                 << QJsonScalar::Double;
+    QTest::newRow("rounded fraction") << QByteArray("1.00000000000000001")
+                                      << QJsonScalar::Number;
+    QTest::newRow("rounded integer") << QByteArray("12345678901234567890")
+                                     << QJsonScalar::Number;
+    QTest::newRow("2^53 + 1") << QByteArray("9007199254740993.0")
+                              << QJsonScalar::Number;
+    QTest::newRow("small") << QByteArray("-1.2345678901234567891e-200")
+                           << QJsonScalar::Number;
+  }
+  void numbers() {
+    QFETCH(QByteArray, number);
+    QFETCH(QJsonScalar::Kind, kind);
+    QJsonModel model;
+    QVERIFY(model.loadJson('[' + number + ']'));
+    const QJsonScalar &scalar = item(model.index(0, 1))->scalar();
+    QCOMPARE(scalar.kind(), kind);
+    if (QJsonScalar::Number == kind) {
+      QCOMPARE(scalar.text(), QString::fromLatin1(number));
+      QVERIFY(model.json(true).contains(number));
+    } else {
+      QCOMPARE(scalar.toDouble(), number.toDouble());
+    }
+  }
+
+  // setData() reads the value as the type of the item, or refuses it
+  void setData_data() {
+    QTest::addColumn<QByteArray>("json");
+    QTest::addColumn<QVariant>("value");
+    QTest::addColumn<QByteArray>("result");
+    const QVariant null = QVariant::fromValue(nullptr);
+    QTest::newRow("string/int") << QByteArray(R"(["s"])") << QVariant(42)
+                                << QByteArray(R"(["42"])");
+    QTest::newRow("string/bool") << QByteArray(R"(["s"])") << QVariant(true)
+                                 << QByteArray(R"(["true"])");
+    QTest::newRow("string/null") << QByteArray(R"(["s"])") << null
+                                 << QByteArray();
+    QTest::newRow("bool/text") << QByteArray("[false]") << QVariant("true")
+                               << QByteArray("[true]");
+    QTest::newRow("bool/padded") << QByteArray("[true]")
+                                 << QVariant(" false ")
+                                 << QByteArray("[false]");
+    QTest::newRow("bool/bool") << QByteArray("[true]") << QVariant(false)
+                               << QByteArray("[false]");
+    QTest::newRow("bool/other text") << QByteArray("[true]")
+                                     << QVariant("yes") << QByteArray();
+    QTest::newRow("bool/int") << QByteArray("[true]") << QVariant(1)
+                              << QByteArray();
+    QTest::newRow("number/integer text") << QByteArray("[1.5]")
+                                         << QVariant("12")
+                                         << QByteArray("[12]");
+    QTest::newRow("number/double text") << QByteArray("[1]")
+                                        << QVariant(" 2.5")
+                                        << QByteArray("[2.5]");
+    QTest::newRow("number/double") << QByteArray("[1]") << QVariant(0.25)
+                                   << QByteArray("[0.25]");
+    QTest::newRow("number/other text") << QByteArray("[1]")
+                                       << QVariant("one") << QByteArray();
+    QTest::newRow("number/bool") << QByteArray("[1]") << QVariant(true)
+                                 << QByteArray();
+    QTest::newRow("null/null") << QByteArray("[null]") << null
+                               << QByteArray("[null]");
+    QTest::newRow("null/number text") << QByteArray("[null]")
+                                      << QVariant("42") << QByteArray("[42]");
+    QTest::newRow("null/double text") << QByteArray("[null]")
+                                      << QVariant("-2.5")
+                                      << QByteArray("[-2.5]");
+    QTest::newRow("null/text") << QByteArray("[null]") << QVariant("x")
+                               << QByteArray(R"(["x"])");
+    QTest::newRow("null/bool text") << QByteArray("[null]")
+                                    << QVariant("true")
+                                    << QByteArray("[true]");
+    QTest::newRow("null/double") << QByteArray("[null]") << QVariant(0.5)
+                                 << QByteArray("[0.5]");
+    QTest::newRow("object") << QByteArray(R"([{"a":1}])") << QVariant(1)
+                            << QByteArray();
+    QTest::newRow("array") << QByteArray("[[1]]") << QVariant("x")
+                           << QByteArray();
+  }
+  void setData() {
+    QFETCH(QByteArray, json);
+    QFETCH(QVariant, value);
+    QFETCH(QByteArray, result);
+    QJsonModel model;
+    QVERIFY(model.loadJson(json));
+    const QModelIndex index = model.index(0, 1);
+    // An empty result means the edit is refused and changes nothing
+    QCOMPARE(model.setData(index, value), !result.isEmpty());
+    QCOMPARE(QJsonDocument::fromJson(model.json()),
+             QJsonDocument::fromJson(result.isEmpty() ? json : result));
+    // The item's type follows its value
+    const QJsonValue expected =
+        QJsonDocument::fromJson(result.isEmpty() ? json : result)
+            .array()
+            .at(0);
+    QCOMPARE(item(index)->type(), expected.type());
+  }
+
+  // Undoing the first value of a null item makes it null again
+  void undoTypedNull() {
+    QJsonModel model;
+    QVERIFY(model.loadJson("[null]"));
+    model.setUndoLimit(10);
+    const QModelIndex index = model.index(0, 1);
+    QVERIFY(model.setData(index, "text"));
+    QCOMPARE(item(index)->type(), QJsonValue::String);
+    QVERIFY(model.undo());
+    QCOMPARE(item(index)->type(), QJsonValue::Null);
+    QCOMPARE(model.json(true), QByteArray("[null]"));
+    QVERIFY(model.redo());
+    QCOMPARE(item(index)->type(), QJsonValue::String);
+    QCOMPARE(QJsonDocument::fromJson(model.json()),
+             QJsonDocument::fromJson(R"(["text"])"));
+  }
+};
+
+QTEST_GUILESS_MAIN(QJsonScalarTest)
+#include "QJsonScalarTest.moc"
@@ -0,0 +1,230 @@
+/* QJsonSearchTest.cpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "QJsonModel.hpp"
+#include <QElapsedTimer>
+#include <QSignalSpy>
+#include <QTest>
+#include <algorithm>
+
+namespace {
+// \a count records, each with a name, a tag and a port of its own
+QByteArray records(int count, const QByteArray &prefix = "server") {
+  QByteArray json = "[";
+  for (int i = 0; i < count; ++i) {
+    const QByteArray n = QByteArray::number(i);
+    json += QByteArray(i ? "," : "") + R"({"id":)" + n + R"(,"name":")" +
+            prefix + "-" + n + R"(","tags":["alpha","beta-)" + n +
+            R"("],"port":)" + QByteArray::number(8000 + i) +
+            R"(,"up":true})";
+  }
+  return json + ']';
+}
+
+// What a search reported: its batches, in order, then the total that
+// searchFinished() gave, or -1 if it never finished
+struct Outcome {
+  QList<QModelIndexList> batches;
+  qint64 finished = -1;
+
+  QStringList paths(const QJsonModel &model) const {
+    QStringList paths;
+    for (const QModelIndexList &batch : batches)
+      for (const QModelIndex &index : batch)
+        paths << model.pathForIndex(index);
+    std::sort(paths.begin(), paths.end());
+    return paths;
+  }
+};
+
+// Records the signals of search \a id until \a model has finished it, or
+// for \a msec when it is not expected to finish
+Outcome collect(QJsonModel &model, int id, int msec = 10000) {
+  Outcome outcome;
+  QObject context;
+  QObject::connect(&model, &QJsonModel::searchResults, &context,
+                   [&](int search, const QModelIndexList &indexes) {
+                     QVERIFY(search == id);
+                     QVERIFY(outcome.finished < 0);
+                     outcome.batches.append(indexes);
+                   });
+  QObject::connect(&model, &QJsonModel::searchFinished, &context,
+                   [&](int search, qint64 matches) {
+                     QVERIFY(search == id);
+                     outcome.finished = matches;
+                   });
+  QElapsedTimer timer;
+  timer.start();
+  while (outcome.finished < 0 && timer.elapsed() < msec)
+    QTest::qWait(10);
+  return outcome;
+}
+
+Outcome search(QJsonModel &model, const QString &pattern,
+               Qt::MatchFlags flags = Qt::MatchContains) {
+  return collect(model, model.find(pattern, flags));
+}
+} // namespace
+
+class QJsonSearchTest : public QObject {
+  Q_OBJECT
+
+private slots:
+  void indexedMatchesUnindexed_data() {
+    QTest::addColumn<QString>("pattern");
+    QTest::addColumn<int>("flags");
+    QTest::addColumn<int>("matches");
+
+    auto row = [](const char *name, const char *pattern, int flags,
+                  int matches) {
+      QTest::newRow(name) << QString::fromUtf8(pattern) << flags << matches;
+    };
+    row("value", "server", Qt::MatchContains, 1000);
+    row("key", "name", Qt::MatchContains, 1000);
+    row("ignoring case", "SERVER-99", Qt::MatchContains, 11);
+    row("case", "SERVER-99", Qt::MatchContains | Qt::MatchCaseSensitive, 0);
+    row("number", "8099", Qt::MatchContains, 1);
+    row("starts with", "beta-9", Qt::MatchStartsWith, 111);
+    row("ends with", "-999", Qt::MatchEndsWith, 2);
+    row("fixed string", "alpha", Qt::MatchFixedString, 1000);
+    // Too short for the index, or not a plain substring: scanned instead
+    row("short", "ru", Qt::MatchContains, 1000);
+    row("wildcard", "server-9?", Qt::MatchWildcard, 10);
+    row("regular expression", "^beta-1\\d$", Qt::MatchRegularExpression, 10);
+  }
+
+  void indexedMatchesUnindexed() {
+    QFETCH(QString, pattern);
+    QFETCH(int, flags);
+    QFETCH(int, matches);
+
+    QJsonModel scanned;
+    QVERIFY(scanned.loadJson(records(1000)));
+    QJsonModel indexed;
+    indexed.setSearchIndexEnabled(true);
+    QVERIFY(indexed.loadJson(records(1000)));
+
+    const Outcome expected = search(scanned, pattern, QFlag(flags));
+    const Outcome actual = search(indexed, pattern, QFlag(flags));
+    QCOMPARE(expected.finished, qint64(matches));
+    QCOMPARE(actual.finished, qint64(matches));
+    QCOMPARE(actual.paths(indexed), expected.paths(scanned));
+    QCOMPARE(expected.paths(scanned).size(), matches);
+  }
+
+  void batches_data() {
+    QTest::addColumn<bool>("indexed");
+    QTest::newRow("scanned") << false;
+    QTest::newRow("indexed") << true;
+  }
+
+  void batches() {
+    QFETCH(bool, indexed);
+
+    QJsonModel model;
+    model.setSearchIndexEnabled(indexed);
+    QVERIFY(model.loadJson(records(5000)));
+    QVERIFY(!model.isFinding());
+    const int id = model.find(QStringLiteral("alpha"));
+    QVERIFY(model.isFinding());
+
+    const Outcome outcome = collect(model, id);
+    QCOMPARE(outcome.finished, qint64(5000));
+    QVERIFY(!model.isFinding());
+    // Several batches, all of them before searchFinished()
+    QVERIFY(outcome.batches.size() > 1);
+    qint64 delivered = 0;
+    for (const QModelIndexList &batch : outcome.batches) {
+      QVERIFY(!batch.isEmpty());
+      QVERIFY(batch.size() <= 256);
+      delivered += batch.size();
+    }
+    QCOMPARE(delivered, outcome.finished);
+  }
+
+  void editCancels_data() { batches_data(); }
+
+  void editCancels() {
+    QFETCH(bool, indexed);
+
+    QJsonModel model;
+    model.setSearchIndexEnabled(indexed);
+    QVERIFY(model.loadJson(records(5000)));
+    const QModelIndex name = model.indexForPath("/4321/name");
+    QVERIFY(name.isValid());
+
+    const int id = model.find(QStringLiteral("server"));
+    QVERIFY(model.setData(name.siblingAtColumn(1), QStringLiteral("needle")));
+    QVERIFY(!model.isFinding());
+    // Nothing of the cancelled search comes through afterwards
+    const Outcome cancelled = collect(model, id, 200);
+    QVERIFY(cancelled.batches.isEmpty());
+    QCOMPARE(cancelled.finished, qint64(-1));
+
+    const Outcome found = search(model, QStringLiteral("needle"));
+    QCOMPARE(found.finished, qint64(1));
+    QCOMPARE(found.paths(model), QStringList{QStringLiteral("/4321/name")});
+    QCOMPARE(search(model, QStringLiteral("server-4321")).finished,
+             qint64(0));
+  }
+
+  void loadInvalidates_data() { batches_data(); }
+
+  void loadInvalidates() {
+    QFETCH(bool, indexed);
+
+    QJsonModel model;
+    model.setSearchIndexEnabled(indexed);
+    QVERIFY(model.loadJson(records(5000)));
+    QSignalSpy resets(&model, &QJsonModel::modelReset);
+
+    const int id = model.find(QStringLiteral("server"));
+    QVERIFY(model.loadJson(records(10, "client")));
+    QCOMPARE(resets.count(), 1);
+    QVERIFY(!model.isFinding());
+    // Results of the old tree would point at freed items
+    const Outcome cancelled = collect(model, id, 200);
+    QVERIFY(cancelled.batches.isEmpty());
+    QCOMPARE(cancelled.finished, qint64(-1));
+
+    QCOMPARE(search(model, QStringLiteral("server")).finished, qint64(0));
+    const Outcome found = search(model, QStringLiteral("client-"));
+    QCOMPARE(found.finished, qint64(10));
+    QCOMPARE(found.paths(model).first(), QStringLiteral("/0/name"));
+  }
+
+  void newSearchCancels() {
+    QJsonModel model;
+    QVERIFY(model.loadJson(records(5000)));
+    const int first = model.find(QStringLiteral("server"));
+    const int second = model.find(QStringLiteral("beta-1234"));
+    QVERIFY(second != first);
+    const Outcome outcome = collect(model, second);
+    QCOMPARE(outcome.finished, qint64(1));
+  }
+};
+
+QTEST_GUILESS_MAIN(QJsonSearchTest)
+
+#include "QJsonSearchTest.moc"
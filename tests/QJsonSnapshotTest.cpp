@@ -0,0 +1,271 @@
+/* QJsonSnapshotTest.cpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "QJsonModel.hpp"
+#include "details/QJsonSnapshot.hpp"
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTest>
+#include <cstddef>
+#include <cstring>
+
+namespace {
+using QJsonSnapshot::Header;
+using QJsonSnapshot::Node;
+
+enum Damage {
+  Missing,
+  Truncated,
+  Extended,
+  OtherMagic,
+  OtherVersion,
+  FlippedByte,
+  SourceChanged,
+  // The rest rewrite the checksum, so that only the structural checks
+  // stand between them and the tree
+  StringPastData,
+  KeyPastStrings,
+  UnknownKind,
+  ChildrenPastNodes,
+  ChildrenOutOfOrder,
+};
+
+bool writeFile(const QString &fileName, const QByteArray &data) {
+  QFile file(fileName);
+  return file.open(QIODevice::WriteOnly) && file.write(data) == data.size();
+}
+
+QByteArray readFile(const QString &fileName) {
+  QFile file(fileName);
+  return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+Header header(const QByteArray &snapshot) {
+  Header header;
+  std::memcpy(&header, snapshot.constData(), sizeof(header));
+  return header;
+}
+
+template <typename T>
+void poke(QByteArray &snapshot, quint64 offset, T value) {
+  std::memcpy(snapshot.data() + offset, &value, sizeof(value));
+}
+
+void reseal(QByteArray &snapshot) {
+  poke(snapshot, offsetof(Header, checksum),
+       QJsonSnapshot::checksum(snapshot.constData() + sizeof(Header),
+                               snapshot.size() - sizeof(Header)));
+}
+
+quint64 nodeOffset(const QByteArray &snapshot, quint64 node) {
+  return QJsonSnapshot::Sections(header(snapshot)).nodes +
+         node * sizeof(Node);
+}
+} // namespace
+
+Q_DECLARE_METATYPE(Damage)
+
+class QJsonSnapshotTest : public QObject {
+  Q_OBJECT
+
+private:
+  QTemporaryDir mDir;
+  QString mSource;
+  QString mSnapshot;
+
+private slots:
+  void init() {
+    QVERIFY(mDir.isValid());
+    mSource = mDir.filePath(QStringLiteral("source.json"));
+    mSnapshot = mDir.filePath(QStringLiteral("source.snapshot"));
+    QFile::remove(mSnapshot);
+  }
+
+  // A tree rebuilt from its snapshot writes the same bytes as the tree
+  // loaded from the JSON
+  void roundTrip_data() {
+    QTest::addColumn<QByteArray>("json");
+    QTest::newRow("empty containers") << QByteArray(R"({"a":[],"b":{}})");
+    QTest::newRow("scalars")
+        << QByteArray(R"([null,true,false,-7,2.5,"",)"
+                      R"(9223372036854775807,12345678901234567890])");
+    QTest::newRow("strings")
+        << QByteArray(R"({"esc\"aped":"tab\tline\n","cjk":"服务器",)"
+                      R"("emoji":"😀","same":"服务器"})");
+    QTest::newRow("nested")
+        << QByteArray(R"({"a":[1,[2,{"b":[{"c":null}]}]],"d":{"e":{}}})");
+    QByteArray wide = "{";
+    for (int i = 0; i < 3 * QJsonTreeItem::KeyIndexThreshold; ++i)
+      wide += (i ? ",\"k" : "\"k") + QByteArray::number(i) + "\":[" +
+              QByteArray::number(i) + "]";
+    QTest::newRow("wide object") << wide + '}';
+  }
+  void roundTrip() {
+    QFETCH(QByteArray, json);
+    QVERIFY(writeFile(mSource, json));
+    QJsonModel model;
+    QVERIFY(model.load(mSource));
+    QVERIFY(model.saveSnapshot(mSnapshot, mSource));
+
+    QJsonModel copy;
+    QVERIFY(copy.loadSnapshot(mSnapshot, mSource));
+    QCOMPARE(copy.json(true), model.json(true));
+    QCOMPARE(copy.json(), model.json());
+    QCOMPARE(QJsonDocument::fromJson(copy.json()),
+             QJsonDocument::fromJson(json));
+    if (json.startsWith('{')) {
+      const QModelIndex first = copy.index(0, 0);
+      const QString path = QStringLiteral("/") + first.data().toString();
+      QCOMPARE(copy.indexForPath(path), first);
+    }
+  }
+
+  // JSON Lines records keep their record number as key once older records
+  // are trimmed and their rows renumbered; plain elements store no key
+  void recordKeys() {
+    QByteArray lines;
+    for (int i = 0; i < 5; ++i)
+      lines += R"({"n":)" + QByteArray::number(i) + "}\n";
+    QVERIFY(writeFile(mSource, lines));
+
+    QJsonModel model;
+    model.setMaxRows(3);
+    model.appendNdjson(lines);
+    model.flushNdjson();
+    QCOMPARE(model.rowCount(), 3);
+    QVERIFY(model.saveSnapshot(mSnapshot, mSource));
+
+    QJsonModel copy;
+    QVERIFY(copy.loadSnapshot(mSnapshot, mSource));
+    QCOMPARE(copy.json(true), model.json(true));
+    for (int row = 0; row < 3; ++row) {
+      QCOMPARE(copy.index(row, 0).data().toString(),
+               QString::number(row + 2));
+      QCOMPARE(copy.pathForIndex(copy.index(row, 0)),
+               QStringLiteral("/") + QString::number(row));
+    }
+
+    // Appending goes on from the last record number
+    copy.appendNdjson(R"({"n":5})" "\n");
+    copy.flushNdjson();
+    QCOMPARE(copy.rowCount(), 4);
+    QCOMPARE(copy.index(3, 0).data().toString(), QStringLiteral("5"));
+
+    // "root" and "n" only
+    QJsonModel plain;
+    QVERIFY(plain.loadJson(R"([{"n":0},{"n":1},{"n":2}])"));
+    QVERIFY(plain.saveSnapshot(mSnapshot, mSource));
+    QCOMPARE(header(readFile(mSnapshot)).stringCount, quint64(2));
+  }
+
+  // Damaged or stale snapshots are refused, and the tree stays as it was
+  void rejects_data() {
+    QTest::addColumn<Damage>("damage");
+    QTest::newRow("missing") << Missing;
+    QTest::newRow("truncated") << Truncated;
+    QTest::newRow("extended") << Extended;
+    QTest::newRow("other magic") << OtherMagic;
+    QTest::newRow("other version") << OtherVersion;
+    QTest::newRow("flipped byte") << FlippedByte;
+    QTest::newRow("source changed") << SourceChanged;
+    QTest::newRow("string past data") << StringPastData;
+    QTest::newRow("key past strings") << KeyPastStrings;
+    QTest::newRow("unknown kind") << UnknownKind;
+    QTest::newRow("children past nodes") << ChildrenPastNodes;
+    QTest::newRow("children out of order") << ChildrenOutOfOrder;
+  }
+  void rejects() {
+    QFETCH(Damage, damage);
+    const QByteArray json =
+        R"({"name":"x","list":[1,"two",3.5,12345678901234567890]})";
+    QVERIFY(writeFile(mSource, json));
+    {
+      QJsonModel model;
+      QVERIFY(model.load(mSource));
+      QVERIFY(model.saveSnapshot(mSnapshot, mSource));
+    }
+    QByteArray snapshot = readFile(mSnapshot);
+    QVERIFY(snapshot.size() > qsizetype(sizeof(Header)));
+    const Header intact = header(snapshot);
+
+    switch (damage) {
+    case Missing:
+      QVERIFY(QFile::remove(mSnapshot));
+      break;
+    case Truncated:
+      snapshot.chop(1);
+      break;
+    case Extended:
+      snapshot.append(8, '\0');
+      break;
+    case OtherMagic:
+      poke(snapshot, offsetof(Header, magic), intact.magic ^ 1);
+      break;
+    case OtherVersion:
+      poke(snapshot, offsetof(Header, version), QJsonSnapshot::Version + 1);
+      break;
+    case FlippedByte:
+      snapshot[snapshot.size() / 2] ^= 0x10;
+      break;
+    case SourceChanged:
+      QVERIFY(writeFile(mSource, json + ' '));
+      break;
+    case StringPastData:
+      // The first string is longer than all the string data
+      poke(snapshot,
+           sizeof(Header) + offsetof(QJsonSnapshot::StringRef, length),
+           intact.stringDataSize + 1);
+      break;
+    case KeyPastStrings:
+      poke(snapshot, nodeOffset(snapshot, 1) + offsetof(Node, key),
+           quint32(intact.stringCount + 1));
+      break;
+    case UnknownKind:
+      poke(snapshot, nodeOffset(snapshot, 1) + offsetof(Node, kind),
+           quint8(QJsonScalar::String + 1));
+      break;
+    case ChildrenPastNodes:
+      poke(snapshot, nodeOffset(snapshot, 0) + offsetof(Node, childCount),
+           quint32(intact.nodeCount));
+      break;
+    case ChildrenOutOfOrder:
+      poke(snapshot, nodeOffset(snapshot, 0) + offsetof(Node, firstChild),
+           quint32(0));
+      break;
+    }
+    if (damage >= StringPastData)
+      reseal(snapshot);
+    if (damage != Missing && damage != SourceChanged)
+      QVERIFY(writeFile(mSnapshot, snapshot));
+
+    QJsonModel model;
+    QVERIFY(model.loadJson("[\"kept\"]"));
+    const QByteArray before = model.json(true);
+    QVERIFY(!model.loadSnapshot(mSnapshot, mSource));
+    QCOMPARE(model.json(true), before);
+  }
+};
+
+QTEST_GUILESS_MAIN(QJsonSnapshotTest)
+#include "QJsonSnapshotTest.moc"
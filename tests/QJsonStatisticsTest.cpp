@@ -0,0 +1,142 @@
+/* QJsonStatisticsTest.cpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "QJsonModel.hpp"
+#include <QSignalSpy>
+#include <QTemporaryFile>
+#include <QTest>
+
+namespace {
+// Three objects, an array, two strings, two numbers, two bools and a null,
+// with "e" three levels below the root
+const QByteArray document =
+    R"({"a":[1,2.5,"x",true,null],"b":{"c":{"d":"e"}},"f":false})";
+
+qint64 nodes(const QJsonModelStatistics &statistics) {
+  return statistics.objects + statistics.arrays + statistics.strings +
+         statistics.numbers + statistics.bools + statistics.nulls;
+}
+
+void checkTree(const QJsonModelStatistics &statistics) {
+  QCOMPARE(nodes(statistics), qint64(11));
+  QCOMPARE(statistics.objects, qint64(3));
+  QCOMPARE(statistics.arrays, qint64(1));
+  QCOMPARE(statistics.strings, qint64(2));
+  QCOMPARE(statistics.numbers, qint64(2));
+  QCOMPARE(statistics.bools, qint64(2));
+  QCOMPARE(statistics.nulls, qint64(1));
+  QCOMPARE(statistics.depth, qint64(3));
+  // Five distinct one-character keys; array elements have none
+  QCOMPARE(statistics.keyBytes, 5 * QJsonKeyPool::stringBytes(1));
+  QVERIFY(statistics.valueBytes >= 2 * QJsonKeyPool::stringBytes(1));
+  QVERIFY(statistics.nodeBytes >= qint64(11 * sizeof(QJsonTreeItem)));
+}
+} // namespace
+
+class QJsonStatisticsTest : public QObject {
+  Q_OBJECT
+
+private slots:
+  void offByDefault() {
+    QJsonModel model;
+    QVERIFY(!model.statisticsEnabled());
+    QSignalSpy updated(&model, &QJsonModel::statisticsUpdated);
+    QVERIFY(model.loadJson(document));
+    model.json();
+    model.index(0, 0).data();
+    QCOMPARE(updated.count(), 0);
+    QCOMPARE(nodes(model.statistics()), qint64(0));
+    QCOMPARE(model.statistics().dataCalls, qint64(0));
+  }
+
+  void treeFigures() {
+    QJsonModel model;
+    model.setStatisticsEnabled(true);
+    QSignalSpy updated(&model, &QJsonModel::statisticsUpdated);
+    QVERIFY(model.loadJson(document));
+    QCOMPARE(updated.count(), 1);
+    checkTree(model.statistics());
+
+    // Another load replaces the figures instead of adding to them
+    QVERIFY(model.loadJson(document));
+    QCOMPARE(updated.count(), 2);
+    checkTree(model.statistics());
+
+    QVERIFY(model.loadJson("[]"));
+    QCOMPARE(nodes(model.statistics()), qint64(1));
+    QCOMPARE(model.statistics().arrays, qint64(1));
+    QCOMPARE(model.statistics().depth, qint64(0));
+  }
+
+  void fileLoad() {
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write(document);
+    file.close();
+
+    QJsonModel model;
+    model.setStatisticsEnabled(true);
+    QSignalSpy updated(&model, &QJsonModel::statisticsUpdated);
+    QVERIFY(model.load(file.fileName()));
+    QCOMPARE(updated.count(), 1);
+    QCOMPARE(model.statistics().loadedBytes, qint64(document.size()));
+    checkTree(model.statistics());
+  }
+
+  void serialization() {
+    QJsonModel model;
+    model.setStatisticsEnabled(true);
+    QVERIFY(model.loadJson(document));
+    QSignalSpy updated(&model, &QJsonModel::statisticsUpdated);
+    const QByteArray json = model.json(true);
+    QCOMPARE(updated.count(), 1);
+    QCOMPARE(model.statistics().serializedBytes, qint64(json.size()));
+    checkTree(model.statistics());
+  }
+
+  void callCounters() {
+    QJsonModel model;
+    model.setStatisticsEnabled(true);
+    QVERIFY(model.loadJson(document));
+    model.resetStatistics();
+
+    const QModelIndex array = model.index(0, 0);
+    const QModelIndex element = model.index(2, 1, array);
+    element.data();
+    element.data();
+    model.parent(element);
+    QCOMPARE(model.statistics().indexCalls, qint64(2));
+    QCOMPARE(model.statistics().dataCalls, qint64(2));
+    QCOMPARE(model.statistics().parentCalls, qint64(1));
+
+    model.resetStatistics();
+    QCOMPARE(model.statistics().dataCalls, qint64(0));
+    QCOMPARE(model.statistics().indexCalls, qint64(0));
+    QCOMPARE(nodes(model.statistics()), qint64(0));
+  }
+};
+
+QTEST_GUILESS_MAIN(QJsonStatisticsTest)
+
+#include "QJsonStatisticsTest.moc"
@@ -0,0 +1,126 @@
+/* QJsonTraversalTest.cpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "QJsonModel.hpp"
+#include <QElapsedTimer>
+#include <QTest>
+#include <limits>
+
+namespace {
+// An array of \a count single-element arrays, so that every parent() of a
+// leaf has to find the row of its parent among \a count siblings
+QByteArray nestedArray(int count) {
+  QByteArray json;
+  json.reserve(count * 10);
+  json += '[';
+  for (int i = 0; i < count; ++i) {
+    if (i)
+      json += ',';
+    json += '[';
+    json += QByteArray::number(i);
+    json += ']';
+  }
+  json += ']';
+  return json;
+}
+
+// Visits every index through index() and parent(), checking each parent
+qint64 walk(const QJsonModel &model, const QModelIndex &parent) {
+  qint64 visited = 0;
+  const int rows = model.rowCount(parent);
+  for (int row = 0; row < rows; ++row) {
+    const QModelIndex child = model.index(row, 0, parent);
+    if (model.parent(child) != parent)
+      return -1;
+    ++visited;
+    if (model.rowCount(child)) {
+      const qint64 below = walk(model, child);
+      if (below < 0)
+        return -1;
+      visited += below;
+    }
+  }
+  return visited;
+}
+
+// Best of a few walks, in nanoseconds
+qint64 timeWalk(const QJsonModel &model, qint64 &visited) {
+  qint64 best = std::numeric_limits<qint64>::max();
+  for (int pass = 0; pass < 3; ++pass) {
+    QElapsedTimer timer;
+    timer.start();
+    visited = walk(model, QModelIndex());
+    best = qMin(best, timer.nsecsElapsed());
+  }
+  return best;
+}
+} // namespace
+
+class QJsonTraversalTest : public QObject {
+  Q_OBJECT
+
+private slots:
+  void walkIsLinear() {
+    constexpr int small = 100000;
+    constexpr int large = 1000000;
+    QJsonModel smallModel;
+    QJsonModel largeModel;
+    QVERIFY(smallModel.loadJson(nestedArray(small)));
+    QVERIFY(largeModel.loadJson(nestedArray(large)));
+
+    qint64 visited = 0;
+    const qint64 smallNs = timeWalk(smallModel, visited);
+    QCOMPARE(visited, qint64(2) * small);
+    const qint64 largeNs = timeWalk(largeModel, visited);
+    QCOMPARE(visited, qint64(2) * large);
+
+    // Ten times the rows: linear takes about 10x, quadratic about 100x.
+    // The bound leaves room for cache effects on the larger tree.
+    const double ratio = double(largeNs) / qMax<qint64>(1, smallNs);
+    qInfo() << "walk of" << large << "rows:" << largeNs / 1000000 << "ms,"
+            << ratio << "times" << small << "rows";
+    QVERIFY2(ratio < 30, qPrintable(QString::number(ratio)));
+  }
+
+  void rowsFollowEdits() {
+    QJsonModel model;
+    QVERIFY(model.loadJson(nestedArray(1000)));
+    QVERIFY(model.removeRows(10, 100, QModelIndex()));
+    QVERIFY(model.insertRows(500, 20, QModelIndex()));
+    QVERIFY(model.moveRows(QModelIndex(), 0, 5, QModelIndex(), 900));
+    QCOMPARE(model.rowCount(), 920);
+
+    QVERIFY(walk(model, QModelIndex()) > 0);
+    for (int row = 0; row < model.rowCount(); ++row) {
+      const QModelIndex child = model.index(row, 0);
+      QCOMPARE(child.row(), row);
+      if (model.rowCount(child))
+        QCOMPARE(model.parent(model.index(0, 0, child)).row(), row);
+    }
+  }
+};
+
+QTEST_GUILESS_MAIN(QJsonTraversalTest)
+
+#include "QJsonTraversalTest.moc"
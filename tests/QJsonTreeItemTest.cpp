@@ -0,0 +1,112 @@
+/* QJsonTreeItemTest.cpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "QJsonModel.hpp"
+#include <QTest>
+
+namespace {
+// An object of \a count members "k0", "k1", ... holding their number
+QByteArray wideObject(int count) {
+  QByteArray json = "{";
+  for (int i = 0; i < count; ++i) {
+    if (i)
+      json += ',';
+    json += "\"k" + QByteArray::number(i) + "\":" + QByteArray::number(i);
+  }
+  return json + '}';
+}
+} // namespace
+
+class QJsonTreeItemTest : public QObject {
+  Q_OBJECT
+
+private slots:
+  void footprint() {
+    // Key, value, 16-byte child list, parent and the out-of-line extras
+    // pointer, then row, type and arena flag: 96 bytes with 64-bit Qt 6,
+    // no more than the key/QVariant/QList/parent/type node this replaced
+    if (sizeof(void *) != 8)
+      QSKIP("The layout figures are for 64-bit builds");
+    qInfo() << "sizeof(QJsonTreeItem):" << sizeof(QJsonTreeItem);
+    QCOMPARE(sizeof(QJsonChildList<QJsonTreeItem>), size_t(16));
+    QVERIFY2(sizeof(QJsonTreeItem) <= 96,
+             qPrintable(QString::number(sizeof(QJsonTreeItem))));
+  }
+
+  void childList() {
+    int items[5] = {};
+    QJsonChildList<int> list;
+    QVERIFY(list.isEmpty());
+    QVERIFY(!list.value(0));
+    for (int &item : items)
+      list.append(&item);
+    list.insert(1, 2, nullptr);
+    QCOMPARE(list.size(), 7);
+    QVERIFY(!list.at(1) && !list.at(2));
+    QCOMPARE(list.at(3), &items[1]);
+    list.remove(1, 2);
+    QCOMPARE(list.takeAt(0), &items[0]);
+    QCOMPARE(list.mid(1, 2), QList<int *>({&items[2], &items[3]}));
+    QCOMPARE(list.toList(),
+             QList<int *>({&items[1], &items[2], &items[3], &items[4]}));
+    QVERIFY(!list.value(4));
+
+    QJsonChildList<int> moved = std::move(list);
+    QVERIFY(list.isEmpty());
+    QCOMPARE(moved.size(), 4);
+    moved.clear();
+    QCOMPARE(moved.capacity(), 0);
+  }
+
+  void keyIndex() {
+    QJsonModel model;
+    QVERIFY(model.loadJson(wideObject(40)));
+    for (int i = 0; i < 40; ++i) {
+      const QModelIndex index = model.indexForPath(
+          QStringLiteral("/k%1").arg(i));
+      QVERIFY(index.isValid());
+      QCOMPARE(index.siblingAtColumn(1).data().toInt(), i);
+    }
+    QVERIFY(!model.indexForPath("/k40").isValid());
+  }
+
+  void lazySource() {
+    QJsonModel model;
+    model.setLazyLoading(true);
+    const QByteArray json = "{\"a\":[1,2,3],\"b\":" + wideObject(20) + '}';
+    QVERIFY(model.loadJson(json));
+    const QModelIndex a = model.index(0, 0);
+    QVERIFY(model.canFetchMore(a));
+    while (model.canFetchMore(a))
+      model.fetchMore(a);
+    QCOMPARE(model.rowCount(a), 3);
+    // Unfetched children are still written from their source
+    QCOMPARE(QJsonDocument::fromJson(model.json()),
+             QJsonDocument::fromJson(json));
+  }
+};
+
+QTEST_GUILESS_MAIN(QJsonTreeItemTest)
+
+#include "QJsonTreeItemTest.moc"
@@ -0,0 +1,164 @@
+/* QJsonUndoTest.cpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "QJsonModel.hpp"
+#include <QSignalSpy>
+#include <QTest>
+
+namespace {
+const QByteArray document = R"({"a":1,"b":[1,2,3],"c":"s","d":true})";
+} // namespace
+
+class QJsonUndoTest : public QObject {
+  Q_OBJECT
+
+private slots:
+  // One step per kind of edit; undoing them one by one walks back through
+  // every state, byte for byte, and redoing walks forward again
+  void undoRedo() {
+    QJsonModel model;
+    QVERIFY(model.loadJson(document));
+    model.setUndoLimit(100);
+    QVERIFY(!model.canUndo());
+
+    const QModelIndex b = model.index(1, 0);
+    QByteArrayList states = {model.json(true)};
+    const auto step = [&] {
+      model.snapshot();
+      states.append(model.json(true));
+    };
+    QVERIFY(model.setData(model.index(0, 1), 2));
+    step();
+    QVERIFY(model.insertValue(b, 1, QJsonArray{4, QJsonObject{{"e", 5}}})
+                .isValid());
+    step();
+    QVERIFY(model.removeRows(0, 1, b));
+    step();
+    QVERIFY(model.moveRows(b, 0, 1, b, 3));
+    step();
+    QVERIFY(model.insertRows(0, 2, {}));
+    step();
+    // From the root object into the array, and back out under a new key
+    QVERIFY(model.moveRows({}, 4, 1, b, 0));
+    step();
+    QVERIFY(model.moveRows(b, 0, 1, {}, 0));
+    step();
+    QCOMPARE(QJsonDocument::fromJson(states.first()),
+             QJsonDocument::fromJson(document));
+
+    for (qsizetype i = states.size() - 1; i > 0; --i) {
+      QVERIFY(model.canUndo());
+      QVERIFY(model.undo());
+      QCOMPARE(model.json(true), states.at(i - 1));
+    }
+    QVERIFY(!model.canUndo());
+    QVERIFY(!model.undo());
+
+    for (qsizetype i = 1; i < states.size(); ++i) {
+      QVERIFY(model.canRedo());
+      QVERIFY(model.redo());
+      QCOMPARE(model.json(true), states.at(i));
+    }
+    QVERIFY(!model.canRedo());
+    QVERIFY(!model.redo());
+  }
+
+  // Edits between two snapshots are one step
+  void stepsGroupEdits() {
+    QJsonModel model;
+    QVERIFY(model.loadJson(document));
+    model.setUndoLimit(10);
+    QVERIFY(model.setData(model.index(0, 1), 7));
+    QVERIFY(model.setData(model.index(2, 1), "t"));
+    QVERIFY(model.removeRows(3, 1, {}));
+    QVERIFY(model.undo());
+    QCOMPARE(QJsonDocument::fromJson(model.json()),
+             QJsonDocument::fromJson(document));
+    QVERIFY(!model.canUndo());
+  }
+
+  void limit() {
+    QJsonModel model;
+    QVERIFY(model.loadJson(document));
+    model.setUndoLimit(2);
+    for (int value = 10; value < 14; ++value) {
+      QVERIFY(model.setData(model.index(0, 1), value));
+      model.snapshot();
+    }
+    QVERIFY(model.undo());
+    QVERIFY(model.undo());
+    QVERIFY(!model.undo());
+    QCOMPARE(model.data(model.index(0, 1), Qt::DisplayRole).toInt(), 11);
+  }
+
+  // A new edit drops the steps that were undone; a refused one records
+  // nothing
+  void editsDropRedo() {
+    QJsonModel model;
+    QVERIFY(model.loadJson(document));
+    model.setUndoLimit(10);
+    QSignalSpy canUndo(&model, &QJsonModel::canUndoChanged);
+    QSignalSpy canRedo(&model, &QJsonModel::canRedoChanged);
+
+    QVERIFY(!model.setData(model.index(3, 1), "maybe"));
+    QVERIFY(!model.canUndo());
+    QCOMPARE(canUndo.count(), 0);
+
+    QVERIFY(model.setData(model.index(3, 1), false));
+    QCOMPARE(canUndo.count(), 1);
+    QVERIFY(model.undo());
+    QVERIFY(model.canRedo());
+    QCOMPARE(canRedo.count(), 1);
+    QVERIFY(model.setData(model.index(0, 1), 3));
+    QVERIFY(!model.canRedo());
+    QCOMPARE(canRedo.count(), 2);
+    QCOMPARE(canRedo.last().first().toBool(), false);
+  }
+
+  // Undo reports rows, never a reset, and loading clears the history
+  void signalsAndReload() {
+    QJsonModel model;
+    QVERIFY(model.loadJson(document));
+    model.setUndoLimit(10);
+    const QModelIndex b = model.index(1, 0);
+    QVERIFY(model.removeRows(0, 2, b));
+    model.snapshot();
+
+    QSignalSpy reset(&model, &QJsonModel::modelReset);
+    QSignalSpy inserted(&model, &QJsonModel::rowsInserted);
+    QVERIFY(model.undo());
+    QCOMPARE(reset.count(), 0);
+    QCOMPARE(inserted.count(), 1);
+    QCOMPARE(inserted.first().at(1).toInt(), 0);
+    QCOMPARE(inserted.first().at(2).toInt(), 1);
+    QCOMPARE(model.rowCount(b), 3);
+
+    QVERIFY(model.loadJson(document));
+    QVERIFY(!model.canUndo());
+    QVERIFY(!model.canRedo());
+  }
+};
+
+QTEST_GUILESS_MAIN(QJsonUndoTest)
+#include "QJsonUndoTest.moc"
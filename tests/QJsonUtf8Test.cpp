@@ -0,0 +1,184 @@
+/* QJsonUtf8Test.cpp
+ * Copyright © 2024 Saul D. Beniquez
+ * License:
+ * The MIT License (MIT)
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+ * DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE
+ * OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "details/QUtf8.hpp"
+#include <QRandomGenerator>
+#include <QTest>
+
+namespace {
+enum Width { Ascii = 1, TwoByte = 2, ThreeByte = 4, Surrogate = 8 };
+
+// A unit of one of the widths set in \a widths, chosen at random; the
+// edges of each range come up often
+ushort randomUnit(QRandomGenerator &random, int widths) {
+  static const Width all[] = {Ascii, TwoByte, ThreeByte, Surrogate};
+  Width width;
+  do
+    width = all[random.bounded(4)];
+  while (!(widths & width));
+  const bool edge = random.bounded(8) == 0;
+  switch (width) {
+  case Ascii:
+    return edge ? 0x7f : ushort(random.bounded(0x80));
+  case TwoByte:
+    return edge ? 0x80 : ushort(0x80 + random.bounded(0x780));
+  case ThreeByte:
+    if (edge)
+      return random.bounded(2) ? 0x800 : 0xffff;
+    return ushort(random.bounded(2) ? 0x800 + random.bounded(0xd000)
+                                    : 0xe000 + random.bounded(0x2000));
+  case Surrogate:
+    return ushort(0xd800 + random.bounded(0x800));
+  }
+  return 0;
+}
+
+// Runs of a single width mixed with mixed stretches, so every block kind
+// of toUtf8Block() comes up
+QList<ushort> randomText(QRandomGenerator &random, qsizetype n) {
+  static const int runs[] = {Ascii, TwoByte, ThreeByte, Ascii | TwoByte,
+                             Ascii | TwoByte | ThreeByte};
+  QList<ushort> units;
+  units.reserve(n);
+  while (units.size() < n) {
+    const int widths = runs[random.bounded(5)];
+    const qsizetype run = qMin<qsizetype>(n - units.size(), random.bounded(40));
+    for (qsizetype i = 0; i < run; ++i)
+      units.append(randomUnit(random, widths));
+  }
+  return units;
+}
+
+// The per code point transcoder toUtf8Block() must match
+QByteArray reference(const ushort *src, const ushort *end) {
+  QByteArray out(4 * (end - src), Qt::Uninitialized);
+  uchar *dst = reinterpret_cast<uchar *>(out.data());
+  while (src != end) {
+    const ushort u = *src++;
+    if (QUtf8Functions::toUtf8<QUtf8BaseTraits>(u, dst, src, end) < 0)
+      return {};
+  }
+  out.truncate(dst - reinterpret_cast<const uchar *>(out.constData()));
+  return out;
+}
+
+// Transcodes [src, end), which holds no surrogate, into a buffer of exactly
+// the documented size followed by guard bytes, and checks every contract
+// of toUtf8Block() and utf8Length()
+void checkBlock(const ushort *src, const ushort *end) {
+  constexpr int guard = 16;
+  const QByteArray expected = reference(src, end);
+  QCOMPARE(QUtf8Functions::utf8Length(src, end), expected.size());
+
+  QByteArray buffer(expected.size() + guard, char(0xa5));
+  uchar *const begin = reinterpret_cast<uchar *>(buffer.data());
+  uchar *dst = begin;
+  const ushort *cursor = src;
+  QUtf8Functions::toUtf8Block(cursor, end, dst);
+  QCOMPARE(cursor, end);
+  QCOMPARE(qsizetype(dst - begin), expected.size());
+  QCOMPARE(buffer.first(expected.size()), expected);
+  QCOMPARE(buffer.sliced(expected.size()), QByteArray(guard, char(0xa5)));
+}
+} // namespace
+
+class QJsonUtf8Test : public QObject {
+  Q_OBJECT
+
+private slots:
+  // Every width mix, every length around the block size of eight and
+  // misaligned starts
+  void blocks_data() {
+    QTest::addColumn<int>("widths");
+    QTest::newRow("ascii") << int(Ascii);
+    QTest::newRow("two byte") << int(TwoByte);
+    QTest::newRow("three byte") << int(ThreeByte);
+    QTest::newRow("ascii and two byte") << int(Ascii | TwoByte);
+    QTest::newRow("two and three byte") << int(TwoByte | ThreeByte);
+    QTest::newRow("all widths") << int(Ascii | TwoByte | ThreeByte);
+  }
+  void blocks() {
+    QFETCH(int, widths);
+    QRandomGenerator random(widths);
+    for (qsizetype length = 0; length < 48; ++length) {
+      for (int round = 0; round < 20; ++round) {
+        QList<ushort> units(length + 3);
+        for (ushort &u : units)
+          u = randomUnit(random, widths);
+        for (qsizetype offset = 0; offset < 4; ++offset) {
+          const ushort *src = units.constData() + offset;
+          checkBlock(src, src + length);
+          if (QTest::currentTestFailed())
+            return;
+        }
+      }
+    }
+  }
+
+  void randomText() {
+    QRandomGenerator random(17);
+    for (int round = 0; round < 2000; ++round) {
+      const QList<ushort> units = ::randomText(random, random.bounded(200));
+      checkBlock(units.constData(), units.constData() + units.size());
+      if (QTest::currentTestFailed())
+        return;
+    }
+  }
+
+  // toUtf8Block() stops at the first surrogate and leaves src there
+  void stopsAtSurrogate() {
+    QRandomGenerator random(18);
+    for (int round = 0; round < 2000; ++round) {
+      QList<ushort> units = ::randomText(random, 1 + random.bounded(100));
+      const qsizetype stop = random.bounded(int(units.size()));
+      units[stop] = randomUnit(random, Surrogate);
+      const ushort *const begin = units.constData();
+      const QByteArray expected = reference(begin, begin + stop);
+
+      QByteArray buffer(3 * units.size(), Qt::Uninitialized);
+      uchar *dst = reinterpret_cast<uchar *>(buffer.data());
+      const ushort *src = begin;
+      QUtf8Functions::toUtf8Block(src, begin + units.size(), dst);
+      QCOMPARE(qsizetype(src - begin), stop);
+      QCOMPARE(qsizetype(reinterpret_cast<char *>(dst) - buffer.constData()),
+               expected.size());
+      QCOMPARE(buffer.first(expected.size()), expected);
+    }
+  }
+
+  // utf8Length() sums in batches of 8 * 65536 units so 32-bit lanes cannot
+  // overflow; cross a couple of batch boundaries
+  void longText() {
+    QRandomGenerator random(19);
+    const QList<ushort> units = ::randomText(random, 2 * 8 * 65536 + 13);
+    checkBlock(units.constData(), units.constData() + units.size());
+    const QList<ushort> cjk(2 * 8 * 65536 + 5, ushort(0x65e5));
+    QCOMPARE(QUtf8Functions::utf8Length(cjk.constData(),
+                                        cjk.constData() + cjk.size()),
+             3 * cjk.size());
+  }
+};
+
+QTEST_GUILESS_MAIN(QJsonUtf8Test)
+#include "QJsonUtf8Test.moc"